@@ -0,0 +1,228 @@
+/*
+ * Copyright (c) 2017 HAW Hamburg
+ *
+ * This file is subject to the terms and conditions of the GNU Lesser
+ * General Public License v2.1. See the file LICENSE in the top level
+ * directory for more details.
+ */
+
+/**
+ * @ingroup     vslab-riot
+ * @{
+ *
+ * @file
+ * @brief       Aggregation of the sensor values of one polling round
+ *
+ * @author      Sebastian Meiling <s@mlng.net>
+ *
+ * @}
+ */
+
+#include "aggr.h"
+
+static inline void _swap(int16_t *a, int16_t *b)
+{
+    int16_t tmp = *a;
+    *a = *b;
+    *b = tmp;
+}
+
+/* quickselect, afterwards values[k] is in place and all before are <= */
+static int16_t _select(int16_t *values, unsigned numof, unsigned k)
+{
+    unsigned lo = 0;
+    unsigned hi = numof - 1;
+    while (lo < hi) {
+        /* median of three as pivot, avoids the worst case on sorted input */
+        unsigned mid = lo + (hi - lo) / 2;
+        if (values[mid] < values[lo]) {
+            _swap(&values[mid], &values[lo]);
+        }
+        if (values[hi] < values[lo]) {
+            _swap(&values[hi], &values[lo]);
+        }
+        if (values[hi] < values[mid]) {
+            _swap(&values[hi], &values[mid]);
+        }
+        int16_t pivot = values[mid];
+        unsigned i = lo;
+        unsigned j = hi;
+        while (i <= j) {
+            while (values[i] < pivot) {
+                i++;
+            }
+            while (values[j] > pivot) {
+                j--;
+            }
+            if (i <= j) {
+                _swap(&values[i], &values[j]);
+                i++;
+                if (j == 0) {
+                    break;
+                }
+                j--;
+            }
+        }
+        if (k <= j) {
+            hi = j;
+        }
+        else if (k >= i) {
+            lo = i;
+        }
+        else {
+            break;
+        }
+    }
+    return values[k];
+}
+
+/* integer division rounding half away from zero */
+static int16_t _div_round(int32_t num, int32_t den)
+{
+    return (int16_t)((num >= 0) ? ((num + den / 2) / den)
+                                : ((num - den / 2) / den));
+}
+
+void aggr_reset(aggr_t *aggr)
+{
+    aggr->count = 0;
+    aggr->min = INT16_MAX;
+    aggr->max = INT16_MIN;
+    aggr->sum = 0;
+    for (unsigned ch = 0; ch < (ELECT_CHANNEL_NUMOF - 1); ch++) {
+        aggr->extra_sum[ch] = 0;
+        aggr->extra_count[ch] = 0;
+    }
+}
+
+bool aggr_add(aggr_t *aggr, int16_t value)
+{
+    if (aggr->count >= ELECT_AGGR_NUMOF) {
+        return false;
+    }
+    aggr->values[aggr->count++] = value;
+    aggr->sum += value;
+    if (value < aggr->min) {
+        aggr->min = value;
+    }
+    if (value > aggr->max) {
+        aggr->max = value;
+    }
+    return true;
+}
+
+bool aggr_add_reading(aggr_t *aggr, const elect_reading_t *reading)
+{
+    if (aggr->count >= ELECT_AGGR_NUMOF) {
+        return false;
+    }
+    if (reading->values[ELECT_CHANNEL_TEMP] != ELECT_VALUE_NONE) {
+        aggr_add(aggr, reading->values[ELECT_CHANNEL_TEMP]);
+    }
+    for (unsigned ch = 1; ch < ELECT_CHANNEL_NUMOF; ch++) {
+        if (reading->values[ch] != ELECT_VALUE_NONE) {
+            aggr->extra_sum[ch - 1] += reading->values[ch];
+            aggr->extra_count[ch - 1]++;
+        }
+    }
+    return true;
+}
+
+void aggr_summary(aggr_t *aggr, elect_summary_t *summary)
+{
+    for (unsigned ch = 0; ch < (ELECT_CHANNEL_NUMOF - 1); ch++) {
+        summary->extra[ch] = (aggr->extra_count[ch] == 0)
+                           ? ELECT_VALUE_NONE
+                           : _div_round(aggr->extra_sum[ch],
+                                        aggr->extra_count[ch]);
+    }
+    summary->count = aggr->count;
+    if (aggr->count == 0) {
+        summary->min = 0;
+        summary->max = 0;
+        summary->mean = 0;
+        summary->median = 0;
+        return;
+    }
+    summary->min = aggr->min;
+    summary->max = aggr->max;
+    summary->mean = _div_round(aggr->sum, aggr->count);
+
+    unsigned k = aggr->count / 2;
+    int16_t upper = _select(aggr->values, aggr->count, k);
+    if (aggr->count & 1) {
+        summary->median = upper;
+        return;
+    }
+    /* even count: the lower middle is the largest value before k */
+    int16_t lower = aggr->values[0];
+    for (unsigned i = 1; i < k; i++) {
+        if (aggr->values[i] > lower) {
+            lower = aggr->values[i];
+        }
+    }
+    summary->median = _div_round((int32_t)lower + upper, 2);
+}
+
+void aggr_merge(elect_summary_t *parts, unsigned numof,
+                elect_summary_t *summary)
+{
+    int32_t sum = 0;
+    uint32_t count = 0;
+    int32_t extra_sum[ELECT_CHANNEL_NUMOF - 1] = { 0 };
+    uint32_t extra_count[ELECT_CHANNEL_NUMOF - 1] = { 0 };
+
+    summary->min = INT16_MAX;
+    summary->max = INT16_MIN;
+    /* insertion sort by median, there are only a few parts */
+    for (unsigned i = 0; i < numof; i++) {
+        elect_summary_t part = parts[i];
+        unsigned j = i;
+        while ((j > 0) && (parts[j - 1].median > part.median)) {
+            parts[j] = parts[j - 1];
+            j--;
+        }
+        parts[j] = part;
+        if (part.count == 0) {
+            continue;
+        }
+        count += part.count;
+        sum += (int32_t)part.mean * part.count;
+        if (part.min < summary->min) {
+            summary->min = part.min;
+        }
+        if (part.max > summary->max) {
+            summary->max = part.max;
+        }
+        for (unsigned ch = 0; ch < (ELECT_CHANNEL_NUMOF - 1); ch++) {
+            if (part.extra[ch] != ELECT_VALUE_NONE) {
+                extra_sum[ch] += (int32_t)part.extra[ch] * part.count;
+                extra_count[ch] += part.count;
+            }
+        }
+    }
+    for (unsigned ch = 0; ch < (ELECT_CHANNEL_NUMOF - 1); ch++) {
+        summary->extra[ch] = (extra_count[ch] == 0)
+                           ? ELECT_VALUE_NONE
+                           : _div_round(extra_sum[ch],
+                                        (int32_t)extra_count[ch]);
+    }
+    summary->count = (uint16_t)((count > UINT16_MAX) ? UINT16_MAX : count);
+    if (count == 0) {
+        summary->min = 0;
+        summary->max = 0;
+        summary->mean = 0;
+        summary->median = 0;
+        return;
+    }
+    summary->mean = _div_round(sum, (int32_t)count);
+
+    uint32_t seen = 0;
+    for (unsigned i = 0; i < numof; i++) {
+        seen += parts[i].count;
+        if ((seen * 2) >= count) {
+            summary->median = parts[i].median;
+            break;
+        }
+    }
+}
@@ -0,0 +1,118 @@
+/*
+ * Copyright (c) 2017 HAW Hamburg
+ *
+ * This file is subject to the terms and conditions of the GNU Lesser
+ * General Public License v2.1. See the file LICENSE in the top level
+ * directory for more details.
+ */
+
+/**
+ * @ingroup     vslab-riot
+ * @{
+ *
+ * @file
+ * @brief       Aggregation of the sensor values of one polling round
+ *
+ * Values are collected in a preallocated buffer, count, min, max and sum are
+ * updated on insert. The median is selected in place when the round is
+ * closed, so no sorting and no allocation is needed. Further channels of a
+ * reading only contribute their mean.
+ *
+ * @author      Sebastian Meiling <s@mlng.net>
+ */
+
+#ifndef AGGR_H
+#define AGGR_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "elect.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * @brief Max. number of values per round, all clients and the coordinator
+ */
+#define ELECT_AGGR_NUMOF        (ELECT_NODES_NUM + 1)
+
+/**
+ * @brief Values of one round
+ */
+typedef struct {
+    int16_t values[ELECT_AGGR_NUMOF];   /**< collected values */
+    uint16_t count;                     /**< number of values */
+    int16_t min;                        /**< smallest value */
+    int16_t max;                        /**< largest value */
+    int32_t sum;                        /**< sum of all values */
+    /** sums of the further channels, starting at channel 1 */
+    int32_t extra_sum[ELECT_CHANNEL_NUMOF - 1];
+    /** number of values of the further channels */
+    uint16_t extra_count[ELECT_CHANNEL_NUMOF - 1];
+} aggr_t;
+
+/**
+ * @brief Start a new round
+ *
+ * @param[out] aggr round
+ */
+void aggr_reset(aggr_t *aggr);
+
+/**
+ * @brief Add a value to the round
+ *
+ * @param[in,out] aggr  round
+ * @param[in] value     value to add
+ *
+ * @returns true on success, false if the round is full
+ */
+bool aggr_add(aggr_t *aggr, int16_t value);
+
+/**
+ * @brief Add all channels of a reading to the round
+ *
+ * Channels of @ref ELECT_VALUE_NONE are skipped.
+ *
+ * @param[in,out] aggr  round
+ * @param[in] reading   reading to add
+ *
+ * @returns true on success, false if the round is full
+ */
+bool aggr_add_reading(aggr_t *aggr, const elect_reading_t *reading);
+
+/**
+ * @brief Close the round and compute its summary
+ *
+ * Reorders the collected values. If the round is empty, all fields of
+ * @p summary but `average` are 0. A further channel without any value is
+ * @ref ELECT_VALUE_NONE.
+ *
+ * @param[in,out] aggr      round
+ * @param[out] summary      count, min, max, mean and median of the round,
+ *                          means of the further channels
+ */
+void aggr_summary(aggr_t *aggr, elect_summary_t *summary);
+
+/**
+ * @brief Merge the summaries of several rounds, e.g. of several clusters
+ *
+ * Mean, min and max are exact. The median is the count weighted median of
+ * the medians of @p parts, an approximation as the values are not at hand.
+ * The means of the further channels are weighted by count as well. Parts
+ * with a count of 0 are skipped.
+ *
+ * @param[in,out] parts     summaries to merge, get reordered
+ * @param[in] numof         number of @p parts
+ * @param[out] summary      merged summary, `average` is not touched
+ */
+void aggr_merge(elect_summary_t *parts, unsigned numof,
+                elect_summary_t *summary);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* AGGR_H */
+/** @} */
@@ -0,0 +1,380 @@
+/*
+ * Copyright (c) 2017 HAW Hamburg
+ *
+ * This file is subject to the terms and conditions of the GNU Lesser
+ * General Public License v2.1. See the file LICENSE in the top level
+ * directory for more details.
+ */
+
+/**
+ * @ingroup     vslab-riot
+ * @{
+ *
+ * @file
+ * @brief       Root tier of the two-tier election
+ *
+ * @author      Sebastian Meiling <s@mlng.net>
+ *
+ * @}
+ */
+
+#include "elect.h"
+
+#if ELECT_CLUSTER
+
+#include <inttypes.h>
+#include <stdio.h>
+#include <string.h>
+
+#include "log.h"
+
+#include "evtimer_msg.h"
+#include "random.h"
+#include "xtimer.h"
+
+#include "aggr.h"
+#include "cluster.h"
+#include "config.h"
+#include "elect_core.h"
+#include "ewma.h"
+#include "rxpool.h"
+
+typedef struct {
+    ipv6_addr_t addr;           /* routable address of the head */
+    elect_summary_t summary;    /* summary of the current round */
+    uint8_t missed;             /* rounds in a row without summary */
+    bool answered;              /* summary received in current round */
+} _head_t;
+
+static elect_core_t _root;
+static elect_params_t _params;
+static bool _active;
+static kernel_pid_t _main_pid;
+
+static evtimer_msg_t _evtimer;
+static evtimer_msg_event_t _events[ELECT_TIMER_NUMOF];
+
+static _head_t _heads[ELECT_CLUSTER_HEADS_NUM];
+static unsigned _heads_numof;
+/* next head to request and requests in flight of the current round */
+static unsigned _next;
+static unsigned _pending;
+static bool _polling;
+
+/* last round of the own cluster, merged like any other head */
+static elect_summary_t _own;
+static ewma_t _average;
+
+static void _poll_next(void)
+{
+    while (_polling && (_pending < ELECT_CLUSTER_WINDOW) &&
+           (_next < _heads_numof)) {
+        if (coap_get_summary(_heads[_next].addr) == 0) {
+            _pending++;
+        }
+        _next++;
+    }
+}
+
+static _head_t *_head_find(const ipv6_addr_t *addr)
+{
+    for (unsigned i = 0; i < _heads_numof; i++) {
+        if (ipv6_addr_equal(&_heads[i].addr, addr)) {
+            return &_heads[i];
+        }
+    }
+    return NULL;
+}
+
+/* --- operations of the root election --- */
+
+static uint32_t _now(void *ctx)
+{
+    (void)ctx;
+    return xtimer_now_usec();
+}
+
+static uint32_t _random(void *ctx, uint32_t max)
+{
+    (void)ctx;
+    return (max > 0) ? random_uint32_range(0, max) : 0;
+}
+
+static void _timer_set(void *ctx, elect_timer_t timer, uint32_t offset)
+{
+    (void)ctx;
+    evtimer_del(&_evtimer, &_events[timer].event);
+    _events[timer].event.offset = offset;
+    evtimer_add_msg(&_evtimer, &_events[timer], _main_pid);
+}
+
+static void _timer_del(void *ctx, elect_timer_t timer)
+{
+    (void)ctx;
+    evtimer_del(&_evtimer, &_events[timer].event);
+}
+
+static int _send_id(void *ctx, const ipv6_addr_t *addr)
+{
+    (void)ctx;
+    return broadcast_root_id(addr);
+}
+
+static int _send_alive(void *ctx, const ipv6_addr_t *addr)
+{
+    (void)ctx;
+    return broadcast_root_alive(addr);
+}
+
+/* the core aggregates the values of round_finish, which are none here, the
+ * merged summaries of the heads replace its result */
+static int _send_summary(void *ctx, const elect_summary_t *summary)
+{
+    (void)ctx;
+    (void)summary;
+    elect_summary_t parts[ELECT_CLUSTER_HEADS_NUM + 1];
+    unsigned numof = 0;
+
+    parts[numof++] = _own;
+    for (unsigned i = 0; i < _heads_numof; i++) {
+        if (_heads[i].answered) {
+            parts[numof++] = _heads[i].summary;
+        }
+    }
+    elect_summary_t merged;
+    aggr_merge(parts, numof, &merged);
+    if (merged.count == 0) {
+        return 0;
+    }
+    merged.average = ewma_update(&_average, merged.mean);
+    printf("Gesamt: %u Werte aus %u Clustern, Mittel %"PRIi16"\n",
+           (unsigned)merged.count, numof, merged.average);
+    return broadcast_root_summary(&merged);
+}
+
+static int _register_at(void *ctx, const ipv6_addr_t *leader,
+                        const ipv6_addr_t *node)
+{
+    (void)ctx;
+    return coap_put_head(*leader, *node);
+}
+
+static void _sensor_read(void *ctx, elect_reading_t *reading)
+{
+    (void)ctx;
+    reading->values[ELECT_CHANNEL_TEMP] = _own.mean;
+    for (unsigned ch = 1; ch < ELECT_CHANNEL_NUMOF; ch++) {
+        reading->values[ch] = _own.extra[ch - 1];
+    }
+}
+
+/* heads keep their clients, there is nothing to fetch or hand over */
+static int _fetch_nodes(void *ctx, const ipv6_addr_t *node)
+{
+    (void)ctx;
+    (void)node;
+    return 0;
+}
+
+static int _handover(void *ctx, const ipv6_addr_t *leader,
+                     const ewma_t *average)
+{
+    (void)ctx;
+    (void)leader;
+    (void)average;
+    return 0;
+}
+
+static void _client_add(void *ctx, const ipv6_addr_t *addr)
+{
+    (void)ctx;
+    _head_t *head = _head_find(addr);
+    if (head == NULL) {
+        if (_heads_numof >= ELECT_CLUSTER_HEADS_NUM) {
+            LOG_WARNING("%s: too many cluster heads\n", __func__);
+            return;
+        }
+        head = &_heads[_heads_numof++];
+        memset(head, 0, sizeof(*head));
+        head->addr = *addr;
+        puts("Cluster-Head hinzugefügt");
+    }
+    head->missed = 0;
+}
+
+static void _clients_clear(void *ctx)
+{
+    (void)ctx;
+    _heads_numof = 0;
+    _polling = false;
+}
+
+static void _round_start(void *ctx)
+{
+    (void)ctx;
+    /* drop heads that stopped answering, they registered elsewhere */
+    unsigned i = 0;
+    while (i < _heads_numof) {
+        if (!_heads[i].answered &&
+            (++_heads[i].missed >= ELECT_CLUSTER_MISSED_MAX)) {
+            _heads[i] = _heads[--_heads_numof];
+            continue;
+        }
+        _heads[i++].answered = false;
+    }
+    _next = 0;
+    _pending = 0;
+    _polling = true;
+    _poll_next();
+}
+
+static unsigned _round_finish(void *ctx, elect_reading_t *readings,
+                              unsigned max)
+{
+    (void)ctx;
+    (void)readings;
+    (void)max;
+    _polling = false;
+    return 0;
+}
+
+static const elect_core_ops_t _root_ops = {
+    .now = _now,
+    .random = _random,
+    .timer_set = _timer_set,
+    .timer_del = _timer_del,
+    .send_id = _send_id,
+    .send_alive = _send_alive,
+    .send_summary = _send_summary,
+    .register_at = _register_at,
+    .sensor_read = _sensor_read,
+    .fetch_nodes = _fetch_nodes,
+    .handover = _handover,
+    .client_add = _client_add,
+    .clients_clear = _clients_clear,
+    .round_start = _round_start,
+    .round_finish = _round_finish,
+};
+
+static void _on_summary(const rxpool_slot_t *slot)
+{
+    if (_pending > 0) {
+        _pending--;
+    }
+    if (slot != NULL) {
+        ipv6_addr_t addr;
+        memcpy(&addr, slot->remote.addr.ipv6, sizeof(addr));
+        _head_t *head = _head_find(&addr);
+        if (_polling && (head != NULL)) {
+            memcpy(&head->summary, slot->data, sizeof(head->summary));
+            head->answered = true;
+            head->missed = 0;
+        }
+    }
+    _poll_next();
+}
+
+/* --- public interface functions --- */
+
+int cluster_init(kernel_pid_t main)
+{
+    _main_pid = main;
+    evtimer_init_msg(&_evtimer);
+    for (unsigned i = 0; i < ELECT_TIMER_NUMOF; i++) {
+        _events[i].msg.type = ELECT_ROOT_TIMER_EVENT + i;
+    }
+    config_params(&_params);
+    ewma_init(&_average, _params.weight_shift);
+    return 0;
+}
+
+void cluster_configure(const elect_params_t *params)
+{
+    _params = *params;
+    ewma_rescale(&_average, params->weight_shift);
+    if (_active) {
+        elect_core_configure(&_root, params);
+    }
+}
+
+void cluster_update(uint8_t state)
+{
+    bool head = (state == ELECT_STATE_COORDINATOR);
+    if (head == _active) {
+        return;
+    }
+    _active = head;
+    if (head) {
+        ipv6_addr_t addr;
+        get_node_global_addr(&addr);
+        puts("Cluster-Head, starte Root-Wahl");
+        elect_core_init(&_root, &addr, &_root_ops, NULL);
+        _root.params = _params;
+        elect_core_start(&_root);
+        return;
+    }
+    for (unsigned i = 0; i < ELECT_TIMER_NUMOF; i++) {
+        evtimer_del(&_evtimer, &_events[i].event);
+    }
+    _clients_clear(NULL);
+    ewma_reset(&_average);
+    memset(&_own, 0, sizeof(_own));
+}
+
+bool cluster_event(const elect_event_t *ev)
+{
+    rxpool_slot_t *slot = ev->data.slot;
+
+    if ((ev->type >= ELECT_ROOT_TIMER_EVENT) &&
+        (ev->type < (ELECT_ROOT_TIMER_EVENT + ELECT_TIMER_NUMOF))) {
+        if (_active) {
+            elect_core_timer(&_root, (elect_timer_t)(ev->type - ELECT_ROOT_TIMER_EVENT));
+        }
+        return true;
+    }
+    switch (ev->type) {
+        case ELECT_ROOT_BROADCAST_EVENT: {
+            elect_frame_t frame;
+            if (!_active ||
+                (elect_frame_decode(&frame, slot->data, slot->len) != 0)) {
+                return true;
+            }
+            if (frame.type == ELECT_FRAME_TYPE_ALIVE) {
+                elect_core_heartbeat(&_root, &frame.addr, frame.seq);
+            }
+            else if (frame.type == ELECT_FRAME_TYPE_ID) {
+                elect_core_id(&_root, &frame.addr);
+            }
+            return true;
+        }
+        case ELECT_ROOT_ALIVE_EVENT:
+            if (_active) {
+                elect_core_alive(&_root);
+            }
+            return true;
+        case ELECT_HEADS_EVENT: {
+            ipv6_addr_t heads[ELECT_NODES_NUM];
+            unsigned numof = coap_nodes_take(ELECT_HEADS_EVENT, heads, ELECT_NODES_NUM);
+            for (unsigned i = 0; _active && (i < numof); i++) {
+                elect_core_node(&_root, &heads[i]);
+            }
+            return true;
+        }
+        case ELECT_ROOT_SUMMARY_EVENT:
+            if (_active) {
+                _on_summary(slot);
+            }
+            return true;
+        default:
+            return false;
+    }
+}
+
+void cluster_publish(const elect_summary_t *summary)
+{
+    _own = *summary;
+}
+
+#else
+typedef int dont_be_pedantic;
+#endif /* ELECT_CLUSTER */
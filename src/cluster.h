@@ -0,0 +1,110 @@
+/*
+ * Copyright (c) 2017 HAW Hamburg
+ *
+ * This file is subject to the terms and conditions of the GNU Lesser
+ * General Public License v2.1. See the file LICENSE in the top level
+ * directory for more details.
+ */
+
+/**
+ * @ingroup     vslab-riot
+ * @{
+ *
+ * @file
+ * @brief       Root tier of the two-tier election, see @ref ELECT_CLUSTER
+ *
+ * While the local node is coordinator of its cluster, it runs a second
+ * @ref elect_core_t among all cluster heads. Its IDs go to
+ * @ref ELECT_BC_ROOT_ADDR and heads register at the root via PUT `/heads`.
+ * Instead of sensor values, the root polls the summary of the last round of
+ * every head via GET `/summary`, merges them with @ref aggr_merge and
+ * broadcasts the result. So the root handles one request per cluster, not
+ * one per node.
+ *
+ * All functions are called from the main thread.
+ *
+ * @author      Sebastian Meiling <s@mlng.net>
+ */
+
+#ifndef CLUSTER_H
+#define CLUSTER_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "kernel_types.h"
+
+#include "elect.h"
+#include "elect_core.h"
+#include "evq.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * @brief Max. number of cluster heads registered at the root
+ */
+#ifndef ELECT_CLUSTER_HEADS_NUM
+#define ELECT_CLUSTER_HEADS_NUM     (8U)
+#endif
+
+/**
+ * @brief Summary requests of the root in flight
+ */
+#ifndef ELECT_CLUSTER_WINDOW
+#define ELECT_CLUSTER_WINDOW        (2U)
+#endif
+
+/**
+ * @brief Rounds a head may miss before the root drops it
+ */
+#ifndef ELECT_CLUSTER_MISSED_MAX
+#define ELECT_CLUSTER_MISSED_MAX    (3U)
+#endif
+
+/**
+ * @brief Initialise the root tier, it stays idle until @ref cluster_update
+ *
+ * @param[in] main  PID of the main thread, receives the timer events
+ *
+ * @returns 0 on success, error otherwise
+ */
+int cluster_init(kernel_pid_t main);
+
+/**
+ * @brief Apply changed parameters to the root election, see config.h
+ *
+ * @param[in] params    parameters of the active configuration
+ */
+void cluster_configure(const elect_params_t *params);
+
+/**
+ * @brief Start or stop the root election on a change of the cluster state
+ *
+ * @param[in] state     state of the cluster election, ELECT_STATE_*
+ */
+void cluster_update(uint8_t state);
+
+/**
+ * @brief Handle an event of the root tier
+ *
+ * @param[in] ev    event popped by the main thread
+ *
+ * @returns true, if @p ev belongs to the root tier
+ */
+bool cluster_event(const elect_event_t *ev);
+
+/**
+ * @brief Pass the summary of the last round of the own cluster
+ *
+ * @param[in] summary   summary of the own cluster
+ */
+void cluster_publish(const elect_summary_t *summary);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* CLUSTER_H */
+/** @} */
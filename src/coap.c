@@ -23,26 +23,85 @@
 #include <stdlib.h>
 #include <string.h>
 
+#include "byteorder.h"
 #include "log.h"
-#include "fmt.h"
 #include "msg.h"
+#include "mutex.h"
 #include "net/gcoap.h"
 #include "net/ipv6/addr.h"
 
+#include "config.h"
 #include "elect.h"
+#include "evq.h"
+#include "history.h"
+#include "metrics.h"
+#include "rxpool.h"
+#include "series.h"
+#include "trace.h"
 
 #define ELECT_COAP_PORT         (5683U)
+#define ELECT_COAP_PATH_CONFIG  ("/config")
 #define ELECT_COAP_PATH_NODES   ("/nodes")
 #define ELECT_COAP_PATH_SENSOR  ("/sensor")
+#define ELECT_COAP_PATH_SERIES  ("/series")
+#define ELECT_COAP_PATH_HANDOVER ("/handover")
+#define ELECT_COAP_PATH_HEADS   ("/heads")
+#define ELECT_COAP_PATH_HISTORY ("/history")
+#define ELECT_COAP_PATH_METRICS ("/metrics")
+#define ELECT_COAP_PATH_SUMMARY ("/summary")
+#define ELECT_COAP_PATH_TRACE   ("/trace")
+/* a push carries the address of the node, followed by the reading as text */
+#define ELECT_COAP_PUSH_MIN_LEN (sizeof(ipv6_addr_t) + 1)
+/* addresses per PUT, leaves room for CoAP header, token and options */
+#define ELECT_COAP_NODES_PER_PUT    ((GCOAP_PDU_BUF_SIZE - 24U - ELECT_NODES_HDR_LEN) / \
+                                     sizeof(ipv6_addr_t))
+/* requested block size of a snapshot, 64 bytes */
+#define ELECT_COAP_BLOCK_SZX    (2U)
+/* fetches of a snapshot that could not be passed to the main thread */
+#define ELECT_COAP_FETCH_RETRIES    (3U)
 
 static void _resp_handler(unsigned req_state, coap_pkt_t* pdu, sock_udp_ep_t *remote);
+static ssize_t _metrics_handler(coap_pkt_t* pdu, uint8_t *buf, size_t len, void *ctx);
 static ssize_t _nodes_handler(coap_pkt_t* pdu, uint8_t *buf, size_t len, void *ctx);
 static ssize_t _sensor_handler(coap_pkt_t* pdu, uint8_t *buf, size_t len, void *ctx);
+static ssize_t _handover_handler(coap_pkt_t* pdu, uint8_t *buf, size_t len, void *ctx);
+static ssize_t _config_handler(coap_pkt_t* pdu, uint8_t *buf, size_t len, void *ctx);
+#if ELECT_CLUSTER
+static ssize_t _heads_handler(coap_pkt_t* pdu, uint8_t *buf, size_t len, void *ctx);
+static ssize_t _summary_handler(coap_pkt_t* pdu, uint8_t *buf, size_t len, void *ctx);
+#endif
+#if ELECT_TRACE
+static ssize_t _trace_handler(coap_pkt_t* pdu, uint8_t *buf, size_t len, void *ctx);
+#endif
+#if ELECT_HISTORY
+static ssize_t _history_handler(coap_pkt_t* pdu, uint8_t *buf, size_t len, void *ctx);
+#endif
+#if ELECT_SERIES
+static ssize_t _series_handler(coap_pkt_t* pdu, uint8_t *buf, size_t len, void *ctx);
+#endif
 
-/* CoAP resources */
+/* CoAP resources, sorted by path */
 static const coap_resource_t _resources[] = {
-    { ELECT_COAP_PATH_NODES,  COAP_PUT,  _nodes_handler, NULL },
-    { ELECT_COAP_PATH_SENSOR, COAP_GET,  _sensor_handler, NULL },
+    { ELECT_COAP_PATH_CONFIG, COAP_GET | COAP_PUT, _config_handler, NULL },
+    { ELECT_COAP_PATH_HANDOVER, COAP_PUT, _handover_handler, NULL },
+#if ELECT_CLUSTER
+    { ELECT_COAP_PATH_HEADS,  COAP_PUT,  _heads_handler, NULL },
+#endif
+#if ELECT_HISTORY
+    { ELECT_COAP_PATH_HISTORY, COAP_GET, _history_handler, NULL },
+#endif
+    { ELECT_COAP_PATH_METRICS, COAP_GET, _metrics_handler, NULL },
+    { ELECT_COAP_PATH_NODES,  COAP_GET | COAP_PUT, _nodes_handler, NULL },
+    { ELECT_COAP_PATH_SENSOR, COAP_GET | COAP_POST, _sensor_handler, NULL },
+#if ELECT_SERIES
+    { ELECT_COAP_PATH_SERIES, COAP_GET, _series_handler, NULL },
+#endif
+#if ELECT_CLUSTER
+    { ELECT_COAP_PATH_SUMMARY, COAP_GET, _summary_handler, NULL },
+#endif
+#if ELECT_TRACE
+    { ELECT_COAP_PATH_TRACE,  COAP_GET,  _trace_handler, NULL },
+#endif
 };
 
 static gcoap_listener_t _listener = {
@@ -53,21 +112,176 @@ static gcoap_listener_t _listener = {
 
 static kernel_pid_t main_pid;
 
+/* membership snapshot served at GET /nodes, written by the main thread */
+static uint8_t _snapshot[ELECT_NODES_LEN(ELECT_NODES_NUM)];
+static size_t _snapshot_len;
+static mutex_t _snapshot_lock = MUTEX_INIT;
+
+#if ELECT_CLUSTER
+/* summary of the own cluster served at GET /summary */
+static uint8_t _summary[ELECT_SUMMARY_LEN];
+static size_t _summary_len;
+static uint16_t _summary_seq;
+static mutex_t _summary_lock = MUTEX_INIT;
+#endif
+
+/* addresses of membership payloads not yet taken by the main thread, see
+ * coap_nodes_take */
+typedef struct {
+    ipv6_addr_t nodes[ELECT_NODES_NUM];
+    unsigned numof;
+} _batch_t;
+
+static _batch_t _nodes_batch;
+#if ELECT_CLUSTER
+static _batch_t _heads_batch;
+#endif
+static mutex_t _batch_lock = MUTEX_INIT;
+
+/* snapshot fetched from another node, see coap_get_nodes */
+static struct {
+    ipv6_addr_t peer;
+    uint8_t buf[ELECT_NODES_LEN(ELECT_NODES_NUM)];
+    size_t len;
+    unsigned szx;
+    unsigned retries;
+} _fetch;
+
+static size_t _nodes_encode(uint8_t *buf, const ipv6_addr_t *nodes,
+                            unsigned numof, uint16_t epoch)
+{
+    buf[0] = ELECT_FRAME_VERSION;
+    buf[1] = (uint8_t)numof;
+    byteorder_htobebufs(&buf[2], epoch);
+    memcpy(&buf[ELECT_NODES_HDR_LEN], nodes, numof * sizeof(ipv6_addr_t));
+    return ELECT_NODES_LEN(numof);
+}
+
+static const coap_resource_t *_resource(const char *path)
+{
+    for (unsigned i = 0; i < (sizeof(_resources) / sizeof(_resources[0])); i++) {
+        if (strcmp(_resources[i].path, path) == 0) {
+            return &_resources[i];
+        }
+    }
+    return NULL;
+}
+
+static _batch_t *_batch_of(uint16_t event)
+{
+#if ELECT_CLUSTER
+    if (event == ELECT_HEADS_EVENT) {
+        return &_heads_batch;
+    }
+#endif
+    return (event == ELECT_NODES_EVENT) ? &_nodes_batch : NULL;
+}
+
+static bool _batch_has(const _batch_t *batch, unsigned numof,
+                       const ipv6_addr_t *addr)
+{
+    for (unsigned i = 0; i < numof; i++) {
+        if (ipv6_addr_equal(&batch->nodes[i], addr)) {
+            return true;
+        }
+    }
+    return false;
+}
+
+/* append all addresses of a membership payload to the batch of the main
+ * thread, either the whole payload is accepted or nothing */
+static int _nodes_post(const uint8_t *buf, size_t len, uint16_t event)
+{
+    if ((len < ELECT_NODES_HDR_LEN) || (buf[0] != ELECT_FRAME_VERSION) ||
+        (len != ELECT_NODES_LEN(buf[1])) || (buf[1] > ELECT_NODES_NUM)) {
+        return -1;
+    }
+    _batch_t *batch = _batch_of(event);
+    if (batch == NULL) {
+        return -1;
+    }
+    int res = 0;
+    mutex_lock(&_batch_lock);
+    unsigned numof = batch->numof;
+    for (unsigned i = 0; i < buf[1]; i++) {
+        ipv6_addr_t addr;
+        memcpy(&addr, &buf[ELECT_NODES_HDR_LEN + (i * sizeof(addr))], sizeof(addr));
+        if (_batch_has(batch, numof, &addr)) {
+            continue;
+        }
+        if (numof == ELECT_NODES_NUM) {
+            res = 1;
+            break;
+        }
+        batch->nodes[numof++] = addr;
+    }
+    /* the first addresses announce the batch, later ones join it */
+    if ((res == 0) && (batch->numof == 0) && (numof > 0) &&
+        (evq_post_type(event) != 0)) {
+        res = 1;
+    }
+    if (res == 0) {
+        batch->numof = numof;
+    }
+    mutex_unlock(&_batch_lock);
+    return res;
+}
+
+/* reassemble a snapshot, the next block is requested by the main thread */
+static void _nodes_resp(coap_pkt_t *pdu)
+{
+    uint32_t blknum = 0;
+    unsigned szx = ELECT_COAP_BLOCK_SZX;
+    int more = coap_get_blockopt(pdu, COAP_OPT_BLOCK2, &blknum, &szx);
+    size_t offset = (more < 0) ? 0 : (blknum << (szx + 4));
+    if ((offset != _fetch.len) ||
+        ((offset + pdu->payload_len) > sizeof(_fetch.buf))) {
+        LOG_WARNING("%s: unexpected block %u\n", __func__, (unsigned)blknum);
+        return;
+    }
+    memcpy(&_fetch.buf[offset], pdu->payload, pdu->payload_len);
+    _fetch.len += pdu->payload_len;
+    _fetch.szx = szx;
+    if (more > 0) {
+        evq_post_value(ELECT_NODES_BLOCK_EVENT, blknum + 1);
+        return;
+    }
+    int res = _nodes_post(_fetch.buf, _fetch.len, ELECT_NODES_EVENT);
+    if (res < 0) {
+        LOG_WARNING("%s: invalid snapshot\n", __func__);
+        return;
+    }
+    if (res > 0) {
+        /* fetched again once the main thread took the pending batch */
+        LOG_WARNING("%s: dropped snapshot\n", __func__);
+        if (_fetch.retries < ELECT_COAP_FETCH_RETRIES) {
+            _fetch.retries++;
+            evq_post_value(ELECT_NODES_BLOCK_EVENT, 0);
+        }
+        return;
+    }
+    LOG_INFO("elect: snapshot epoch=%u nodes=%u\n",
+             (unsigned)byteorder_bebuftohs(&_fetch.buf[2]),
+             (unsigned)_fetch.buf[1]);
+}
+
 static void _resp_handler(unsigned req_state, coap_pkt_t* pdu,
                           sock_udp_ep_t *remote)
 {
     LOG_DEBUG("%s: begin\n", __func__);
-    (void)remote;
-    msg_t sensor_msg = { .type = ELECT_SENSOR_EVENT };
 
     if (req_state == GCOAP_MEMO_TIMEOUT) {
         LOG_ERROR("gcoap: timeout for msg ID %02u\n", coap_get_id(pdu));
+        TRACE(ELECT_TRACE_COAP_TIMEOUT, 0, NULL, (int16_t)coap_get_id(pdu));
+        metrics_inc(ELECT_METRICS_COAP_TIMEOUT);
+        evq_post_value(ELECT_POLL_TIMEOUT_EVENT, coap_get_id(pdu));
         return;
     }
     else if (req_state == GCOAP_MEMO_ERR) {
         LOG_ERROR("gcoap: error in response\n");
         return;
     }
+    metrics_inc(ELECT_METRICS_COAP_RESP);
 
     char *class_str = (coap_get_code_class(pdu) == COAP_CLASS_SUCCESS)
                             ? "Success" : "Error";
@@ -77,8 +291,14 @@ static void _resp_handler(unsigned req_state, coap_pkt_t* pdu,
     if (pdu->payload_len) {
         unsigned content_type = coap_get_content_type(pdu);
         if (content_type == COAP_FORMAT_TEXT) {
-            sensor_msg.content.ptr = pdu->payload;
-            msg_send_receive(&sensor_msg, &sensor_msg, main_pid);
+            rxpool_slot_t *slot = rxpool_put(pdu->payload, pdu->payload_len,
+                                             remote);
+            if (slot != NULL) {
+                evq_post_slot(ELECT_SENSOR_EVENT, slot);
+            }
+        }
+        else if (content_type == COAP_FORMAT_OCTET) {
+            _nodes_resp(pdu);
         }
         else if ((content_type == COAP_FORMAT_LINK) ||
                  (coap_get_code_class(pdu) == COAP_CLASS_CLIENT_FAILURE) ||
@@ -94,21 +314,244 @@ static void _resp_handler(unsigned req_state, coap_pkt_t* pdu,
     LOG_DEBUG("%s: done\n", __func__);
 }
 
+static ssize_t _nodes_get(coap_pkt_t* pdu, uint8_t *buf, size_t len)
+{
+    coap_block_slicer_t slicer;
+
+    mutex_lock(&_snapshot_lock);
+    if (_snapshot_len == 0) {
+        mutex_unlock(&_snapshot_lock);
+        return gcoap_response(pdu, buf, len, COAP_CODE_NOT_FOUND);
+    }
+    coap_block2_init(pdu, &slicer);
+    gcoap_resp_init(pdu, buf, len, COAP_CODE_CONTENT);
+    coap_opt_add_format(pdu, COAP_FORMAT_OCTET);
+    coap_opt_add_block2(pdu, &slicer, true);
+    ssize_t hlen = coap_opt_finish(pdu, COAP_OPT_FINISH_PAYLOAD);
+    size_t plen = coap_blockwise_put_bytes(&slicer, pdu->payload,
+                                           _snapshot, _snapshot_len);
+    mutex_unlock(&_snapshot_lock);
+    coap_block2_finish(&slicer);
+    return hlen + plen;
+}
+
+#if ELECT_TRACE
+/* the ring moves on between blocks, the header tells how far */
+static ssize_t _trace_handler(coap_pkt_t* pdu, uint8_t *buf, size_t len, void *ctx)
+{
+    (void)ctx;
+    metrics_inc(ELECT_METRICS_COAP_SERVED);
+    coap_block_slicer_t slicer;
+    uint8_t enc[ELECT_TRACE_REC_LEN];
+    trace_rec_t rec;
+
+    coap_block2_init(pdu, &slicer);
+    gcoap_resp_init(pdu, buf, len, COAP_CODE_CONTENT);
+    coap_opt_add_format(pdu, COAP_FORMAT_OCTET);
+    coap_opt_add_block2(pdu, &slicer, true);
+    ssize_t hlen = coap_opt_finish(pdu, COAP_OPT_FINISH_PAYLOAD);
+    unsigned numof = trace_encode_hdr(enc);
+    size_t plen = coap_blockwise_put_bytes(&slicer, pdu->payload,
+                                           enc, ELECT_TRACE_HDR_LEN);
+    for (unsigned i = 0; (i < numof) && trace_get(i, &rec); i++) {
+        trace_encode_rec(enc, &rec);
+        plen += coap_blockwise_put_bytes(&slicer, pdu->payload + plen,
+                                         enc, ELECT_TRACE_REC_LEN);
+    }
+    coap_block2_finish(&slicer);
+    return hlen + plen;
+}
+#endif
+
+#if ELECT_HISTORY || ELECT_SERIES
+/* value of the query parameter @p name, e.g. "since=", or @p def */
+static uint32_t _query_u32(coap_pkt_t *pdu, const char *name, uint32_t def)
+{
+    char query[32];
+    if (coap_opt_get_string(pdu, COAP_OPT_URI_QUERY, (uint8_t *)query,
+                            sizeof(query), '&') <= 0) {
+        return def;
+    }
+    size_t nlen = strlen(name);
+    for (char *p = query; (p = strchr(p, '&')) != NULL; ) {
+        p++;
+        if (strncmp(p, name, nlen) == 0) {
+            return (uint32_t)strtoul(p + nlen, NULL, 10);
+        }
+    }
+    return def;
+}
+#endif
+
+#if ELECT_HISTORY
+/* like the trace, the ring may move on between blocks */
+static ssize_t _history_handler(coap_pkt_t* pdu, uint8_t *buf, size_t len, void *ctx)
+{
+    (void)ctx;
+    metrics_inc(ELECT_METRICS_COAP_SERVED);
+    coap_block_slicer_t slicer;
+    uint8_t enc[ELECT_HISTORY_REC_LEN];
+    history_rec_t rec;
+    unsigned first;
+    unsigned numof = history_range(_query_u32(pdu, "since=", 0),
+                                   _query_u32(pdu, "until=", 0), &first);
+
+    coap_block2_init(pdu, &slicer);
+    gcoap_resp_init(pdu, buf, len, COAP_CODE_CONTENT);
+    coap_opt_add_format(pdu, COAP_FORMAT_OCTET);
+    coap_opt_add_block2(pdu, &slicer, true);
+    ssize_t hlen = coap_opt_finish(pdu, COAP_OPT_FINISH_PAYLOAD);
+    history_encode_hdr(enc, numof);
+    size_t plen = coap_blockwise_put_bytes(&slicer, pdu->payload,
+                                           enc, ELECT_HISTORY_HDR_LEN);
+    for (unsigned i = 0; (i < numof) && history_get(first + i, &rec); i++) {
+        history_encode_rec(enc, &rec);
+        plen += coap_blockwise_put_bytes(&slicer, pdu->payload + plen,
+                                         enc, ELECT_HISTORY_REC_LEN);
+    }
+    coap_block2_finish(&slicer);
+    return hlen + plen;
+}
+#endif
+
+#if ELECT_SERIES
+/* output of the downsampled series into the response */
+typedef struct {
+    coap_block_slicer_t *slicer;
+    uint8_t *payload;
+    size_t len;
+} _series_out_t;
+
+static void _series_rec(void *ctx, uint32_t time, int16_t temp, int16_t hum)
+{
+    _series_out_t *out = ctx;
+    uint8_t enc[ELECT_SERIES_REC_LEN];
+    byteorder_htobebufl(&enc[0], time);
+    byteorder_htobebufs(&enc[4], (uint16_t)temp);
+    byteorder_htobebufs(&enc[6], (uint16_t)hum);
+    out->len += coap_blockwise_put_bytes(out->slicer, out->payload + out->len,
+                                         enc, ELECT_SERIES_REC_LEN);
+}
+
+/* the stored blocks, or with step=<n> decoded means of n samples */
+static ssize_t _series_handler(coap_pkt_t* pdu, uint8_t *buf, size_t len, void *ctx)
+{
+    (void)ctx;
+    metrics_inc(ELECT_METRICS_COAP_SERVED);
+    coap_block_slicer_t slicer;
+    series_block_t block;
+    uint8_t enc[ELECT_SERIES_BLOCK_HDR_LEN];
+    uint32_t step = _query_u32(pdu, "step=", 0);
+    unsigned numof = series_blocks();
+
+    if (step > 0) {
+        unsigned samples = 0;
+        for (unsigned i = 0; series_get(i, &block); i++) {
+            samples += block.count;
+        }
+        numof = samples / step;
+    }
+    coap_block2_init(pdu, &slicer);
+    gcoap_resp_init(pdu, buf, len, COAP_CODE_CONTENT);
+    coap_opt_add_format(pdu, COAP_FORMAT_OCTET);
+    coap_opt_add_block2(pdu, &slicer, true);
+    ssize_t hlen = coap_opt_finish(pdu, COAP_OPT_FINISH_PAYLOAD);
+    enc[0] = ELECT_SERIES_VERSION;
+    enc[1] = (step > 0) ? ELECT_SERIES_FMT_RECORDS : ELECT_SERIES_FMT_BLOCKS;
+    byteorder_htobebufs(&enc[2], (uint16_t)numof);
+    byteorder_htobebufl(&enc[4], (uint32_t)(xtimer_now_usec64() / US_PER_SEC));
+    _series_out_t out = { .slicer = &slicer, .payload = pdu->payload };
+    out.len = coap_blockwise_put_bytes(&slicer, pdu->payload, enc,
+                                       ELECT_SERIES_HDR_LEN);
+    if (step > 0) {
+        series_read(step, _series_rec, &out);
+    }
+    else {
+        for (unsigned i = 0; (i < numof) && series_get(i, &block); i++) {
+            byteorder_htobebufl(&enc[0], block.start);
+            byteorder_htobebufs(&enc[4], (uint16_t)block.temp);
+            byteorder_htobebufs(&enc[6], (uint16_t)block.hum);
+            byteorder_htobebufs(&enc[8], block.count);
+            enc[10] = block.len;
+            out.len += coap_blockwise_put_bytes(&slicer, pdu->payload + out.len,
+                                                enc, ELECT_SERIES_BLOCK_HDR_LEN);
+            out.len += coap_blockwise_put_bytes(&slicer, pdu->payload + out.len,
+                                                block.data, block.len);
+        }
+    }
+    coap_block2_finish(&slicer);
+    return hlen + out.len;
+}
+#endif
+
+static ssize_t _metrics_handler(coap_pkt_t* pdu, uint8_t *buf, size_t len, void *ctx)
+{
+    (void)ctx;
+    metrics_inc(ELECT_METRICS_COAP_SERVED);
+    coap_block_slicer_t slicer;
+    uint8_t enc[ELECT_METRICS_HDR_LEN];
+
+    coap_block2_init(pdu, &slicer);
+    gcoap_resp_init(pdu, buf, len, COAP_CODE_CONTENT);
+    coap_opt_add_format(pdu, COAP_FORMAT_OCTET);
+    coap_opt_add_block2(pdu, &slicer, true);
+    ssize_t hlen = coap_opt_finish(pdu, COAP_OPT_FINISH_PAYLOAD);
+    unsigned numof = metrics_encode_hdr(enc);
+    size_t plen = coap_blockwise_put_bytes(&slicer, pdu->payload,
+                                           enc, ELECT_METRICS_HDR_LEN);
+    for (unsigned i = 0; i < numof; i++) {
+        byteorder_htobebufl(enc, metrics_get(i));
+        plen += coap_blockwise_put_bytes(&slicer, pdu->payload + plen,
+                                         enc, sizeof(uint32_t));
+    }
+    coap_block2_finish(&slicer);
+    return hlen + plen;
+}
+
 static ssize_t _nodes_handler(coap_pkt_t* pdu, uint8_t *buf, size_t len, void *ctx)
 {
     (void)ctx;
+    metrics_inc(ELECT_METRICS_COAP_SERVED);
 
     LOG_DEBUG("%s: begin (buflen=%u)\n", __func__, (unsigned)len);
     /* read coap method type in packet */
     unsigned method_flag = coap_method2flag(coap_get_code_detail(pdu));
-    msg_t nodes_msg = { .type = ELECT_NODES_EVENT };
-    //ipv6_addr_t addr;
+    rxpool_slot_t *slot;
     switch(method_flag) {
+        case COAP_GET:
+            return _nodes_get(pdu, buf, len);
         case COAP_PUT:
-            LOG_DEBUG("%s: received put with payload: %s\n", __func__, (char *)pdu->payload);
-            if (pdu->payload_len > 6) {
-                nodes_msg.content.ptr = pdu->payload;
-                msg_send_receive(&nodes_msg, &nodes_msg, main_pid);
+            LOG_DEBUG("%s: received put with %u bytes\n", __func__, pdu->payload_len);
+            if ((pdu->payload_len > 0) &&
+                (pdu->payload[0] == ELECT_FRAME_VERSION)) {
+                switch (_nodes_post(pdu->payload, pdu->payload_len,
+                                    ELECT_NODES_EVENT)) {
+                    case 0:
+                        return gcoap_response(pdu, buf, len, COAP_CODE_CHANGED);
+                    case 1:
+                        return gcoap_response(pdu, buf, len,
+                                              COAP_CODE_SERVICE_UNAVAILABLE);
+                    default:
+                        return gcoap_response(pdu, buf, len,
+                                              COAP_CODE_BAD_REQUEST);
+                }
+            }
+            if ((pdu->payload_len > 6) &&
+                (pdu->payload_len < IPV6_ADDR_MAX_STR_LEN)) {
+                /* text from older nodes, passed on as binary address */
+                char str[IPV6_ADDR_MAX_STR_LEN];
+                ipv6_addr_t node;
+                memcpy(str, pdu->payload, pdu->payload_len);
+                str[pdu->payload_len] = '\0';
+                if (ipv6_addr_from_str(&node, str) == NULL) {
+                    return gcoap_response(pdu, buf, len, COAP_CODE_BAD_REQUEST);
+                }
+                slot = rxpool_put((uint8_t *)&node, sizeof(node), NULL);
+                if ((slot == NULL) ||
+                    (evq_post_slot(ELECT_NODES_EVENT, slot) != 0)) {
+                    return gcoap_response(pdu, buf, len,
+                                          COAP_CODE_SERVICE_UNAVAILABLE);
+                }
                 return gcoap_response(pdu, buf, len, COAP_CODE_CHANGED);
             }
             else {
@@ -119,23 +562,178 @@ static ssize_t _nodes_handler(coap_pkt_t* pdu, uint8_t *buf, size_t len, void *c
     return 0;
 }
 
+/* write options and payload of a sensor response or notification, all
+ * channels in one payload, see elect_reading_fmt */
+static ssize_t _sensor_resp(coap_pkt_t *pdu, const elect_reading_t *reading)
+{
+    coap_opt_add_format(pdu, COAP_FORMAT_TEXT);
+    coap_opt_add_uint(pdu, COAP_OPT_MAX_AGE,
+                      config_scale(ELECT_SENSOR_MAX_AGE * MS_PER_SEC) / MS_PER_SEC);
+    ssize_t hlen = coap_opt_finish(pdu, COAP_OPT_FINISH_PAYLOAD);
+    size_t plen = elect_reading_fmt((char *)pdu->payload, reading);
+    pdu->payload[plen++] = '\0';
+    return hlen + plen;
+}
+
 static ssize_t _sensor_handler(coap_pkt_t* pdu, uint8_t *buf, size_t len, void *ctx)
 {
     (void)ctx;
+    metrics_inc(ELECT_METRICS_COAP_SERVED);
 
     LOG_DEBUG("%s: begin (buflen=%u)\n", __func__, (unsigned)len);
-    msg_t leader_msg = { .type = ELECT_LEADER_ALIVE_EVENT };
+    unsigned method_flag = coap_method2flag(coap_get_code_detail(pdu));
+    if (method_flag == COAP_POST) {
+        /* reading pushed by a client, see coap_push_sensor */
+        if ((pdu->payload_len < ELECT_COAP_PUSH_MIN_LEN) ||
+            (pdu->payload_len > (sizeof(ipv6_addr_t) + ELECT_READING_STR_LEN))) {
+            return gcoap_response(pdu, buf, len, COAP_CODE_BAD_REQUEST);
+        }
+        sock_udp_ep_t node = { .family = AF_INET6 };
+        memcpy(node.addr.ipv6, pdu->payload, sizeof(ipv6_addr_t));
+        rxpool_slot_t *slot = rxpool_put(pdu->payload + sizeof(ipv6_addr_t),
+                                         pdu->payload_len - sizeof(ipv6_addr_t),
+                                         &node);
+        if ((slot == NULL) ||
+            (evq_post_slot(ELECT_SENSOR_PUSH_EVENT, slot) != 0)) {
+            return gcoap_response(pdu, buf, len,
+                                  COAP_CODE_SERVICE_UNAVAILABLE);
+        }
+        return gcoap_response(pdu, buf, len, COAP_CODE_CHANGED);
+    }
+    /* a GET with Observe registers the requester, handled by gcoap */
     gcoap_resp_init(pdu, buf, len, COAP_CODE_CONTENT);
-    /* write the RIOT board name in the response buffer */
-    int16_t val = sensor_read();
-    size_t plen = fmt_s16_dec((char *)pdu->payload, val);
-    pdu->payload[plen++] = '\0';
-    msg_send_receive(&leader_msg, &leader_msg, main_pid);
+    elect_reading_t reading;
+    sensor_read(&reading);
+    ssize_t res = _sensor_resp(pdu, &reading);
+    evq_post_type(ELECT_LEADER_ALIVE_EVENT);
     LOG_DEBUG("%s: done\n", __func__);
-    return gcoap_finish(pdu, plen, COAP_FORMAT_TEXT);;
+    return res;
 }
 
-static size_t _send(const uint8_t *buf, size_t len, const ipv6_addr_t *addr)
+static ssize_t _config_handler(coap_pkt_t* pdu, uint8_t *buf, size_t len, void *ctx)
+{
+    (void)ctx;
+    metrics_inc(ELECT_METRICS_COAP_SERVED);
+
+    LOG_DEBUG("%s: begin (buflen=%u)\n", __func__, (unsigned)len);
+    unsigned method_flag = coap_method2flag(coap_get_code_detail(pdu));
+    if (method_flag == COAP_GET) {
+        gcoap_resp_init(pdu, buf, len, COAP_CODE_CONTENT);
+        coap_opt_add_format(pdu, COAP_FORMAT_TEXT);
+        ssize_t hlen = coap_opt_finish(pdu, COAP_OPT_FINISH_PAYLOAD);
+        size_t plen = config_fmt((char *)pdu->payload,
+                                 len - (size_t)(pdu->payload - buf));
+        if (plen == 0) {
+            return gcoap_response(pdu, buf, len, COAP_CODE_INTERNAL_SERVER_ERROR);
+        }
+        return hlen + plen;
+    }
+    /* changes apply as a whole, unnamed parameters keep their value */
+    config_t config;
+    config_read(&config);
+    if ((pdu->payload_len > ELECT_CONFIG_STR_LEN) ||
+        (config_parse(&config, (char *)pdu->payload, pdu->payload_len) != 0) ||
+        (config_check(&config) != 0)) {
+        return gcoap_response(pdu, buf, len, COAP_CODE_BAD_REQUEST);
+    }
+    /* committed by the main thread, which owns the election state */
+    rxpool_slot_t *slot = rxpool_put((uint8_t *)&config, sizeof(config), NULL);
+    if ((slot == NULL) ||
+        (evq_post_slot(ELECT_CONFIG_EVENT, slot) != 0)) {
+        return gcoap_response(pdu, buf, len, COAP_CODE_SERVICE_UNAVAILABLE);
+    }
+    LOG_DEBUG("%s: done\n", __func__);
+    return gcoap_response(pdu, buf, len, COAP_CODE_CHANGED);
+}
+
+static ssize_t _handover_handler(coap_pkt_t* pdu, uint8_t *buf, size_t len, void *ctx)
+{
+    (void)ctx;
+    metrics_inc(ELECT_METRICS_COAP_SERVED);
+
+    LOG_DEBUG("%s: begin (buflen=%u)\n", __func__, (unsigned)len);
+    if ((pdu->payload_len != ELECT_HANDOVER_LEN) ||
+        (pdu->payload[0] != ELECT_FRAME_VERSION)) {
+        return gcoap_response(pdu, buf, len, COAP_CODE_BAD_REQUEST);
+    }
+    elect_handover_t state;
+    state.valid = (pdu->payload[1] & ELECT_HANDOVER_VALID);
+    state.epoch = byteorder_bebuftohs(&pdu->payload[2]);
+    state.average = (int32_t)byteorder_bebuftohl(&pdu->payload[4]);
+    memcpy(&state.from, &pdu->payload[8], sizeof(state.from));
+    rxpool_slot_t *slot = rxpool_put((uint8_t *)&state, sizeof(state), NULL);
+    if ((slot == NULL) ||
+        (evq_post_slot(ELECT_HANDOVER_EVENT, slot) != 0)) {
+        return gcoap_response(pdu, buf, len, COAP_CODE_SERVICE_UNAVAILABLE);
+    }
+    LOG_DEBUG("%s: done\n", __func__);
+    return gcoap_response(pdu, buf, len, COAP_CODE_CHANGED);
+}
+
+#if ELECT_CLUSTER
+static ssize_t _heads_handler(coap_pkt_t* pdu, uint8_t *buf, size_t len, void *ctx)
+{
+    (void)ctx;
+    metrics_inc(ELECT_METRICS_COAP_SERVED);
+
+    LOG_DEBUG("%s: begin (buflen=%u)\n", __func__, (unsigned)len);
+    switch (_nodes_post(pdu->payload, pdu->payload_len, ELECT_HEADS_EVENT)) {
+        case 0:
+            return gcoap_response(pdu, buf, len, COAP_CODE_CHANGED);
+        case 1:
+            return gcoap_response(pdu, buf, len, COAP_CODE_SERVICE_UNAVAILABLE);
+        default:
+            return gcoap_response(pdu, buf, len, COAP_CODE_BAD_REQUEST);
+    }
+}
+
+static ssize_t _summary_handler(coap_pkt_t* pdu, uint8_t *buf, size_t len, void *ctx)
+{
+    (void)ctx;
+    metrics_inc(ELECT_METRICS_COAP_SERVED);
+
+    LOG_DEBUG("%s: begin (buflen=%u)\n", __func__, (unsigned)len);
+    mutex_lock(&_summary_lock);
+    if (_summary_len == 0) {
+        mutex_unlock(&_summary_lock);
+        return gcoap_response(pdu, buf, len, COAP_CODE_NOT_FOUND);
+    }
+    gcoap_resp_init(pdu, buf, len, COAP_CODE_CONTENT);
+    coap_opt_add_format(pdu, COAP_FORMAT_OCTET);
+    ssize_t hlen = coap_opt_finish(pdu, COAP_OPT_FINISH_PAYLOAD);
+    memcpy(pdu->payload, _summary, _summary_len);
+    size_t plen = _summary_len;
+    mutex_unlock(&_summary_lock);
+    /* only the root polls summaries */
+    evq_post_type(ELECT_ROOT_ALIVE_EVENT);
+    return hlen + plen;
+}
+
+static void _summary_resp_handler(unsigned req_state, coap_pkt_t* pdu,
+                                  sock_udp_ep_t *remote)
+{
+    elect_summary_t summary;
+    metrics_inc((req_state == GCOAP_MEMO_TIMEOUT) ? ELECT_METRICS_COAP_TIMEOUT
+                                                  : ELECT_METRICS_COAP_RESP);
+    if ((req_state != GCOAP_MEMO_RESP) ||
+        (coap_get_code_class(pdu) != COAP_CLASS_SUCCESS) ||
+        (elect_summary_decode(&summary, pdu->payload, pdu->payload_len) != 0)) {
+        LOG_DEBUG("%s: no summary\n", __func__);
+        evq_post_type(ELECT_ROOT_SUMMARY_EVENT);
+        return;
+    }
+    rxpool_slot_t *slot = rxpool_put((uint8_t *)&summary, sizeof(summary),
+                                     remote);
+    if (slot == NULL) {
+        evq_post_type(ELECT_ROOT_SUMMARY_EVENT);
+        return;
+    }
+    evq_post_slot(ELECT_ROOT_SUMMARY_EVENT, slot);
+}
+#endif
+
+static size_t _send_req(const uint8_t *buf, size_t len,
+                        const ipv6_addr_t *addr, gcoap_resp_handler_t handler)
 {
     LOG_DEBUG("%s: begin\n", __func__);
     sock_udp_ep_t remote;
@@ -148,14 +746,50 @@ static size_t _send(const uint8_t *buf, size_t len, const ipv6_addr_t *addr)
     remote.port     = ELECT_COAP_PORT;
 
     memcpy(&remote.addr.ipv6[0], &addr->u8[0], sizeof(addr->u8));
+    size_t res = gcoap_req_send2(buf, len, &remote, handler);
+    metrics_inc((res > 0) ? ELECT_METRICS_COAP_SENT : ELECT_METRICS_COAP_SEND_FAIL);
     LOG_DEBUG("%s: done\n", __func__);
-    return gcoap_req_send2(buf, len, &remote, _resp_handler);
+    return res;
+}
+
+static size_t _send(const uint8_t *buf, size_t len, const ipv6_addr_t *addr)
+{
+    return _send_req(buf, len, addr, _resp_handler);
+}
+
+/* an acknowledged push shows that the leader knows this client */
+static void _push_resp_handler(unsigned req_state, coap_pkt_t* pdu,
+                               sock_udp_ep_t *remote)
+{
+    (void)remote;
+    metrics_inc((req_state == GCOAP_MEMO_TIMEOUT) ? ELECT_METRICS_COAP_TIMEOUT
+                                                  : ELECT_METRICS_COAP_RESP);
+    if ((req_state == GCOAP_MEMO_RESP) &&
+        (coap_get_code_class(pdu) == COAP_CLASS_SUCCESS)) {
+        evq_post_type(ELECT_LEADER_ALIVE_EVENT);
+    }
+}
+
+/* a registration not acknowledged by the leader is repeated by the main
+ * thread, see elect_core_register_failed */
+static void _register_resp_handler(unsigned req_state, coap_pkt_t* pdu,
+                                   sock_udp_ep_t *remote)
+{
+    (void)remote;
+    metrics_inc((req_state == GCOAP_MEMO_TIMEOUT) ? ELECT_METRICS_COAP_TIMEOUT
+                                                  : ELECT_METRICS_COAP_RESP);
+    if ((req_state != GCOAP_MEMO_RESP) ||
+        (coap_get_code_class(pdu) != COAP_CLASS_SUCCESS)) {
+        LOG_WARNING("%s: registration failed\n", __func__);
+        evq_post_type(ELECT_REGISTER_FAILED_EVENT);
+    }
 }
 
 /* --- public coap interface --- */
 
 int coap_put_node(ipv6_addr_t addr, ipv6_addr_t node)
 {
+#ifdef ELECT_FRAME_TEXT
     LOG_DEBUG("%s: begin\n", __func__);
     uint8_t buf[GCOAP_PDU_BUF_SIZE];
     coap_pkt_t pdu;
@@ -173,6 +807,73 @@ int coap_put_node(ipv6_addr_t addr, ipv6_addr_t node)
     pdu.payload[len++] = '\0';
     len = gcoap_finish(&pdu, len, COAP_FORMAT_TEXT);
 
+    if (!_send_req(&buf[0], len, &addr, _register_resp_handler)) {
+        LOG_ERROR("%s: send failed!\n", __func__);
+        return 2;
+    }
+    LOG_DEBUG("%s: done\n", __func__);
+    return 0;
+#else
+    LOG_DEBUG("%s: begin\n", __func__);
+    uint8_t buf[GCOAP_PDU_BUF_SIZE];
+    coap_pkt_t pdu;
+    size_t len;
+
+    gcoap_req_init(&pdu, &buf[0], GCOAP_PDU_BUF_SIZE,
+                   COAP_METHOD_PUT, ELECT_COAP_PATH_NODES);
+    len = _nodes_encode(pdu.payload, &node, 1, 0);
+    len = gcoap_finish(&pdu, len, COAP_FORMAT_OCTET);
+    if (!_send_req(&buf[0], len, &addr, _register_resp_handler)) {
+        LOG_ERROR("%s: send failed!\n", __func__);
+        return 2;
+    }
+    LOG_DEBUG("%s: done\n", __func__);
+    return 0;
+#endif
+}
+
+int coap_put_nodes(ipv6_addr_t addr, const ipv6_addr_t *nodes,
+                   unsigned numof, uint16_t epoch)
+{
+    LOG_DEBUG("%s: begin (numof=%u)\n", __func__, numof);
+    uint8_t buf[GCOAP_PDU_BUF_SIZE];
+    coap_pkt_t pdu;
+    size_t len;
+
+    do {
+        unsigned n = (numof < ELECT_COAP_NODES_PER_PUT) ? numof
+                                                        : ELECT_COAP_NODES_PER_PUT;
+        gcoap_req_init(&pdu, &buf[0], GCOAP_PDU_BUF_SIZE,
+                       COAP_METHOD_PUT, ELECT_COAP_PATH_NODES);
+        len = _nodes_encode(pdu.payload, nodes, n, epoch);
+        len = gcoap_finish(&pdu, len, COAP_FORMAT_OCTET);
+        if (!_send(&buf[0], len, &addr)) {
+            LOG_ERROR("%s: send failed!\n", __func__);
+            return 2;
+        }
+        nodes += n;
+        numof -= n;
+    } while (numof > 0);
+    LOG_DEBUG("%s: done\n", __func__);
+    return 0;
+}
+
+int coap_put_handover(ipv6_addr_t addr, const elect_handover_t *state)
+{
+    LOG_DEBUG("%s: begin\n", __func__);
+    uint8_t buf[GCOAP_PDU_BUF_SIZE];
+    coap_pkt_t pdu;
+    size_t len;
+
+    gcoap_req_init(&pdu, &buf[0], GCOAP_PDU_BUF_SIZE,
+                   COAP_METHOD_PUT, ELECT_COAP_PATH_HANDOVER);
+    pdu.payload[0] = ELECT_FRAME_VERSION;
+    pdu.payload[1] = state->valid ? ELECT_HANDOVER_VALID : 0;
+    byteorder_htobebufs(&pdu.payload[2], state->epoch);
+    byteorder_htobebufl(&pdu.payload[4], (uint32_t)state->average);
+    memcpy(&pdu.payload[8], &state->from, sizeof(state->from));
+    len = gcoap_finish(&pdu, ELECT_HANDOVER_LEN, COAP_FORMAT_OCTET);
+
     if (!_send(&buf[0], len, &addr)) {
         LOG_ERROR("%s: send failed!\n", __func__);
         return 2;
@@ -181,13 +882,119 @@ int coap_put_node(ipv6_addr_t addr, ipv6_addr_t node)
     return 0;
 }
 
-int coap_get_sensor(ipv6_addr_t addr)
+static int _get_nodes_block(uint32_t blknum)
+{
+    uint8_t buf[GCOAP_PDU_BUF_SIZE];
+    coap_pkt_t pdu;
+
+    gcoap_req_init(&pdu, &buf[0], GCOAP_PDU_BUF_SIZE,
+                   COAP_METHOD_GET, ELECT_COAP_PATH_NODES);
+    coap_opt_add_uint(&pdu, COAP_OPT_BLOCK2, (blknum << 4) | _fetch.szx);
+    ssize_t len = coap_opt_finish(&pdu, COAP_OPT_FINISH_NONE);
+    if ((len < 0) || !_send(&buf[0], len, &_fetch.peer)) {
+        LOG_ERROR("%s: send failed!\n", __func__);
+        return 1;
+    }
+    return 0;
+}
+
+int coap_get_nodes(ipv6_addr_t addr)
+{
+    LOG_DEBUG("%s: begin\n", __func__);
+    _fetch.peer = addr;
+    _fetch.len = 0;
+    _fetch.szx = ELECT_COAP_BLOCK_SZX;
+    _fetch.retries = 0;
+    return _get_nodes_block(0);
+}
+
+int coap_get_nodes_next(uint32_t blknum)
+{
+    if (blknum == 0) {
+        /* a dropped snapshot is fetched again from the start */
+        _fetch.len = 0;
+        _fetch.szx = ELECT_COAP_BLOCK_SZX;
+    }
+    return _get_nodes_block(blknum);
+}
+
+#if ELECT_CLUSTER
+int coap_put_head(ipv6_addr_t addr, ipv6_addr_t node)
+{
+    LOG_DEBUG("%s: begin\n", __func__);
+    uint8_t buf[GCOAP_PDU_BUF_SIZE];
+    coap_pkt_t pdu;
+    size_t len;
+
+    gcoap_req_init(&pdu, &buf[0], GCOAP_PDU_BUF_SIZE,
+                   COAP_METHOD_PUT, ELECT_COAP_PATH_HEADS);
+    len = _nodes_encode(pdu.payload, &node, 1, 0);
+    len = gcoap_finish(&pdu, len, COAP_FORMAT_OCTET);
+    if (!_send(&buf[0], len, &addr)) {
+        LOG_ERROR("%s: send failed!\n", __func__);
+        return 2;
+    }
+    return 0;
+}
+
+int coap_get_summary(ipv6_addr_t addr)
+{
+    LOG_DEBUG("%s: begin\n", __func__);
+    uint8_t buf[GCOAP_PDU_BUF_SIZE];
+    coap_pkt_t pdu;
+    size_t len = gcoap_request(&pdu, &buf[0], GCOAP_PDU_BUF_SIZE,
+                               COAP_METHOD_GET, ELECT_COAP_PATH_SUMMARY);
+    if (!_send_req(&buf[0], len, &addr, _summary_resp_handler)) {
+        LOG_ERROR("%s: send failed!\n", __func__);
+        return 1;
+    }
+    return 0;
+}
+
+void coap_summary_publish(const elect_summary_t *summary)
+{
+    mutex_lock(&_summary_lock);
+    _summary_len = elect_summary_encode(_summary, sizeof(_summary),
+                                        _summary_seq++, summary);
+    mutex_unlock(&_summary_lock);
+}
+#endif
+
+void coap_nodes_publish(const ipv6_addr_t *nodes, unsigned numof,
+                        uint16_t epoch)
+{
+    if (numof > ELECT_NODES_NUM) {
+        numof = ELECT_NODES_NUM;
+    }
+    mutex_lock(&_snapshot_lock);
+    _snapshot_len = _nodes_encode(_snapshot, nodes, numof, epoch);
+    mutex_unlock(&_snapshot_lock);
+}
+
+unsigned coap_nodes_take(uint16_t event, ipv6_addr_t *nodes, unsigned max)
+{
+    _batch_t *batch = _batch_of(event);
+    if (batch == NULL) {
+        return 0;
+    }
+    mutex_lock(&_batch_lock);
+    unsigned numof = (batch->numof < max) ? batch->numof : max;
+    memcpy(nodes, batch->nodes, numof * sizeof(ipv6_addr_t));
+    batch->numof = 0;
+    mutex_unlock(&_batch_lock);
+    return numof;
+}
+
+int coap_get_sensor(ipv6_addr_t addr, uint16_t *msg_id)
 {
     LOG_DEBUG("%s: begin\n", __func__);
     uint8_t buf[GCOAP_PDU_BUF_SIZE];
     coap_pkt_t pdu;
     size_t len = gcoap_request(&pdu, &buf[0], GCOAP_PDU_BUF_SIZE,
                                COAP_METHOD_GET, ELECT_COAP_PATH_SENSOR);
+    if (msg_id != NULL) {
+        *msg_id = coap_get_id(&pdu);
+    }
 
     if (!_send(&buf[0], len, &addr)) {
         LOG_ERROR("%s: send failed!\n", __func__);
@@ -197,6 +1004,50 @@ int coap_get_sensor(ipv6_addr_t addr)
     return 0;
 }
 
+int coap_push_sensor(ipv6_addr_t addr, ipv6_addr_t node,
+                     const elect_reading_t *reading)
+{
+    LOG_DEBUG("%s: begin\n", __func__);
+    uint8_t buf[GCOAP_PDU_BUF_SIZE];
+    coap_pkt_t pdu;
+    size_t len;
+
+    gcoap_req_init(&pdu, &buf[0], GCOAP_PDU_BUF_SIZE,
+                   COAP_METHOD_POST, ELECT_COAP_PATH_SENSOR);
+    memcpy(pdu.payload, &node, sizeof(node));
+    len = sizeof(node);
+    len += elect_reading_fmt((char *)pdu.payload + len, reading);
+    len = gcoap_finish(&pdu, len, COAP_FORMAT_OCTET);
+
+    if (!_send_req(&buf[0], len, &addr, _push_resp_handler)) {
+        LOG_ERROR("%s: send failed!\n", __func__);
+        return 1;
+    }
+    LOG_DEBUG("%s: done\n", __func__);
+    return 0;
+}
+
+int coap_notify_sensor(const elect_reading_t *reading)
+{
+    LOG_DEBUG("%s: begin\n", __func__);
+    uint8_t buf[GCOAP_PDU_BUF_SIZE];
+    coap_pkt_t pdu;
+    const coap_resource_t *resource = _resource(ELECT_COAP_PATH_SENSOR);
+
+    if (gcoap_obs_init(&pdu, &buf[0], GCOAP_PDU_BUF_SIZE, resource) !=
+        GCOAP_OBS_INIT_OK) {
+        /* no observer registered */
+        return 0;
+    }
+    ssize_t len = _sensor_resp(&pdu, reading);
+    if (gcoap_obs_send(&buf[0], len, resource) == 0) {
+        LOG_ERROR("%s: send failed!\n", __func__);
+        return 0;
+    }
+    LOG_DEBUG("%s: done\n", __func__);
+    return 1;
+}
+
 int coap_init(kernel_pid_t main)
 {
     main_pid = main;
@@ -0,0 +1,195 @@
+/*
+ * Copyright (c) 2017 HAW Hamburg
+ *
+ * This file is subject to the terms and conditions of the GNU Lesser
+ * General Public License v2.1. See the file LICENSE in the top level
+ * directory for more details.
+ */
+
+/**
+ * @ingroup     vslab-riot
+ * @{
+ *
+ * @file
+ * @brief       Parameters changeable at runtime
+ *
+ * @author      Sebastian Meiling <s@mlng.net>
+ *
+ * @}
+ */
+
+#include <stdbool.h>
+#include <stdio.h>
+#include <string.h>
+
+#include "config.h"
+#include "elect.h"
+#include "sensor.h"
+
+/**
+ * @brief Name and valid range of a parameter
+ */
+typedef struct {
+    const char *name;   /**< name in requests and responses */
+    int32_t min;        /**< smallest valid value */
+    int32_t max;        /**< largest valid value */
+    bool pow2;          /**< value has to be a power of two */
+} _desc_t;
+
+static const _desc_t _desc[ELECT_CONFIG_NUMOF] = {
+    [ELECT_CONFIG_INTERVAL]  = { "interval", 100, 60000, false },
+    [ELECT_CONFIG_THRESHOLD] = { "threshold", 100, 600000, false },
+    [ELECT_CONFIG_TIMEOUT]   = { "timeout", 100, 600000, false },
+    [ELECT_CONFIG_WEIGHT]    = { "weight", 2, 256, true },
+    [ELECT_CONFIG_NODES]     = { "nodes", 1, ELECT_NODES_NUM, false },
+    [ELECT_CONFIG_ALPHA]     = { "alpha", 1, 16, false },
+    [ELECT_CONFIG_TXPOWER]   = { "txpower", -30, 30, false },
+};
+
+/* defaults, written by the main thread only, single values are read word-wise */
+static config_t _active = {
+    .values = {
+        [ELECT_CONFIG_INTERVAL]  = ELECT_MSG_INTERVAL,
+        [ELECT_CONFIG_THRESHOLD] = ELECT_THRESHOLD,
+        [ELECT_CONFIG_TIMEOUT]   = ELECT_LEADER_TIMEOUT,
+        [ELECT_CONFIG_WEIGHT]    = ELECT_WEIGHT,
+        [ELECT_CONFIG_NODES]     = ELECT_NODES_NUM,
+        [ELECT_CONFIG_ALPHA]     = ELECT_SENSOR_ALPHA,
+        /* replaced by the value of the radio on start, see net_init */
+        [ELECT_CONFIG_TXPOWER]   = 0,
+    },
+};
+
+static int _find(const char *name, size_t len)
+{
+    for (unsigned i = 0; i < ELECT_CONFIG_NUMOF; i++) {
+        if ((strlen(_desc[i].name) == len) &&
+            (memcmp(_desc[i].name, name, len) == 0)) {
+            return (int)i;
+        }
+    }
+    return -1;
+}
+
+static bool _is_sep(char c)
+{
+    return (c == '&') || (c == ',') || (c == '\n') || (c == '\r');
+}
+
+int32_t config_get(config_param_t param)
+{
+    return _active.values[param];
+}
+
+uint32_t config_scale(uint32_t ms)
+{
+    return (uint32_t)(((uint64_t)ms * (uint32_t)_active.values[ELECT_CONFIG_INTERVAL]) /
+                      ELECT_MSG_INTERVAL);
+}
+
+void config_read(config_t *config)
+{
+    *config = _active;
+}
+
+int config_parse(config_t *config, const char *buf, size_t len)
+{
+    size_t i = 0;
+    while ((i < len) && (buf[i] != '\0')) {
+        if (_is_sep(buf[i])) {
+            i++;
+            continue;
+        }
+        size_t name = i;
+        while ((i < len) && (buf[i] != '=') && !_is_sep(buf[i])) {
+            i++;
+        }
+        if ((i >= len) || (buf[i] != '=')) {
+            return 1;
+        }
+        int param = _find(&buf[name], i - name);
+        if (param < 0) {
+            return 1;
+        }
+        i++;
+        bool neg = ((i < len) && (buf[i] == '-'));
+        if (neg) {
+            i++;
+        }
+        size_t digits = i;
+        int32_t val = 0;
+        while ((i < len) && (buf[i] >= '0') && (buf[i] <= '9')) {
+            val = (val * 10) + (buf[i++] - '0');
+            if (val > 10000000) {
+                return 1;
+            }
+        }
+        if ((i == digits) ||
+            ((i < len) && (buf[i] != '\0') && !_is_sep(buf[i]))) {
+            return 1;
+        }
+        config->values[param] = neg ? -val : val;
+    }
+    return 0;
+}
+
+int config_check(const config_t *config)
+{
+    const int32_t *v = config->values;
+    for (unsigned i = 0; i < ELECT_CONFIG_NUMOF; i++) {
+        if ((v[i] < _desc[i].min) || (v[i] > _desc[i].max)) {
+            return 1;
+        }
+        if (_desc[i].pow2 && (v[i] & (v[i] - 1))) {
+            return 1;
+        }
+    }
+    /* a leader needs some intervals to be identified, and to be declared dead,
+     * values must outlive a poll, see the check of ELECT_SENSOR_MAX_AGE, which
+     * scales with the interval */
+    int64_t max_age = ((int64_t)ELECT_SENSOR_MAX_AGE * MS_PER_SEC *
+                       v[ELECT_CONFIG_INTERVAL]) / ELECT_MSG_INTERVAL;
+    if ((v[ELECT_CONFIG_THRESHOLD] <= v[ELECT_CONFIG_INTERVAL]) ||
+        (v[ELECT_CONFIG_TIMEOUT] <= (2 * v[ELECT_CONFIG_INTERVAL])) ||
+        (v[ELECT_CONFIG_TIMEOUT] <= max_age)) {
+        return 1;
+    }
+    return 0;
+}
+
+unsigned config_commit(const config_t *config)
+{
+    unsigned changed = 0;
+    for (unsigned i = 0; i < ELECT_CONFIG_NUMOF; i++) {
+        if (_active.values[i] != config->values[i]) {
+            _active.values[i] = config->values[i];
+            changed |= (1U << i);
+        }
+    }
+    return changed;
+}
+
+size_t config_fmt(char *buf, size_t len)
+{
+    size_t pos = 0;
+    for (unsigned i = 0; i < ELECT_CONFIG_NUMOF; i++) {
+        int n = snprintf(&buf[pos], len - pos, "%s=%ld\n", _desc[i].name,
+                         (long)_active.values[i]);
+        if ((n < 0) || ((size_t)n >= (len - pos))) {
+            return 0;
+        }
+        pos += (size_t)n;
+    }
+    return pos;
+}
+
+void config_params(elect_params_t *params)
+{
+    params->interval = (uint32_t)_active.values[ELECT_CONFIG_INTERVAL];
+    params->threshold = (uint32_t)_active.values[ELECT_CONFIG_THRESHOLD];
+    params->timeout = (uint32_t)_active.values[ELECT_CONFIG_TIMEOUT];
+    params->weight_shift = 0;
+    while ((1 << (params->weight_shift + 1)) <= _active.values[ELECT_CONFIG_WEIGHT]) {
+        params->weight_shift++;
+    }
+}
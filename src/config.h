@@ -0,0 +1,150 @@
+/*
+ * Copyright (c) 2017 HAW Hamburg
+ *
+ * This file is subject to the terms and conditions of the GNU Lesser
+ * General Public License v2.1. See the file LICENSE in the top level
+ * directory for more details.
+ */
+
+/**
+ * @ingroup     vslab-riot
+ * @{
+ *
+ * @file
+ * @brief       Parameters changeable at runtime
+ *
+ * The compile time macros, e.g. @ref ELECT_MSG_INTERVAL, are the defaults.
+ * A candidate configuration is parsed from text and checked as a whole, so
+ * a request either applies completely or not at all. Only the main thread
+ * commits a configuration, other threads read single values.
+ *
+ * @author      Sebastian Meiling <s@mlng.net>
+ */
+
+#ifndef CONFIG_H
+#define CONFIG_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include "elect_core.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * @brief Runtime parameters
+ */
+typedef enum {
+    ELECT_CONFIG_INTERVAL = 0,  /**< shortest election interval in ms */
+    ELECT_CONFIG_THRESHOLD,     /**< leader threshold in ms */
+    ELECT_CONFIG_TIMEOUT,       /**< leader timeout in ms */
+    ELECT_CONFIG_WEIGHT,        /**< weight of the moving average, power of two */
+    ELECT_CONFIG_NODES,         /**< max. number of registered clients */
+    ELECT_CONFIG_ALPHA,         /**< smoothing of the dummy sensor */
+    ELECT_CONFIG_TXPOWER,       /**< transmit power in dBm */
+    ELECT_CONFIG_NUMOF          /**< number of parameters */
+} config_param_t;
+
+/**
+ * @brief Mask of the parameters used by the election state machine
+ */
+#define ELECT_CONFIG_TIMING     ((1U << ELECT_CONFIG_INTERVAL) | \
+                                 (1U << ELECT_CONFIG_THRESHOLD) | \
+                                 (1U << ELECT_CONFIG_TIMEOUT) | \
+                                 (1U << ELECT_CONFIG_WEIGHT))
+
+/**
+ * @brief Max. length of the text of a configuration
+ */
+#define ELECT_CONFIG_STR_LEN    (ELECT_CONFIG_NUMOF * 20)
+
+/**
+ * @brief A complete configuration
+ */
+typedef struct {
+    int32_t values[ELECT_CONFIG_NUMOF]; /**< value per @ref config_param_t */
+} config_t;
+
+/**
+ * @brief Get a value of the active configuration
+ *
+ * @param[in] param parameter
+ *
+ * @returns value
+ */
+int32_t config_get(config_param_t param);
+
+/**
+ * @brief Scale a default duration to the active interval
+ *
+ * @param[in] ms    duration in ms derived from @ref ELECT_MSG_INTERVAL
+ *
+ * @returns duration in ms derived from the interval of the active
+ *          configuration
+ */
+uint32_t config_scale(uint32_t ms);
+
+/**
+ * @brief Copy the active configuration
+ *
+ * @param[out] config   copy
+ */
+void config_read(config_t *config);
+
+/**
+ * @brief Set values from text
+ *
+ * Pairs `name=value` are separated by `&`, `,` or a newline, parameters not
+ * named keep their value in @p config.
+ *
+ * @param[in,out] config    configuration to change
+ * @param[in] buf           text, needs no termination
+ * @param[in] len           length of @p buf
+ *
+ * @returns 0 on success, 1 on an unknown name or a malformed value
+ */
+int config_parse(config_t *config, const char *buf, size_t len);
+
+/**
+ * @brief Check ranges and dependencies of a configuration
+ *
+ * @param[in] config    configuration
+ *
+ * @returns 0 if valid, 1 otherwise
+ */
+int config_check(const config_t *config);
+
+/**
+ * @brief Make a checked configuration the active one
+ *
+ * @param[in] config    configuration, see @ref config_check
+ *
+ * @returns mask of the changed parameters, bit n is @ref config_param_t n
+ */
+unsigned config_commit(const config_t *config);
+
+/**
+ * @brief Print the active configuration as `name=value` lines
+ *
+ * @param[out] buf  output buffer
+ * @param[in] len   size of @p buf
+ *
+ * @returns number of bytes written, 0 if @p buf is too small
+ */
+size_t config_fmt(char *buf, size_t len);
+
+/**
+ * @brief Get the parameters of the election state machine
+ *
+ * @param[out] params   parameters of the active configuration
+ */
+void config_params(elect_params_t *params);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* CONFIG_H */
+/** @} */
@@ -21,6 +21,8 @@
 #define ELECT_H
 
 #include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
 
 #include "net/ipv6/addr.h"
 #include "xtimer.h"
@@ -38,17 +40,196 @@ extern "C" {
 
 /**
  * @name Parameters for the election algorithm
+ *
+ * Can be overridden via CFLAGS, e.g. to benchmark them with
+ * `tools/elect_sim.py`.
  * @{
  */
+#ifndef ELECT_MSG_INTERVAL
 #define ELECT_MSG_INTERVAL      (2U * MS_PER_SEC)           /**< periodic election interval in ms */
+#endif
+#ifndef ELECT_LEADER_THRESHOLD
 #define ELECT_LEADER_THRESHOLD  (5U * ELECT_MSG_INTERVAL)   /**< interval after which a leader is identified */
+#endif
+#ifndef ELECT_LEADER_TIMEOUT
 #define ELECT_LEADER_TIMEOUT    (7U * ELECT_MSG_INTERVAL)   /**< timeout after which a leader is dead */
+#endif
+/** @} */
+
+/**
+ * @name Adaptive timing
+ *
+ * The values above are the shortest intervals. A coordinator doubles its
+ * interval after every round without a sign of inconsistency, i.e. an ID
+ * of another node, a registration or a handover, up to
+ * @ref ELECT_MSG_INTERVAL_MAX, and falls back to @ref ELECT_MSG_INTERVAL on
+ * the next one, like a trickle timer (RFC 6206). Clients scale their leader
+ * timeout with the observed interval of the leader, up to
+ * @ref ELECT_LEADER_TIMEOUT_MAX. Discovery always runs at the shortest
+ * intervals. Set both bounds to the shortest values to disable.
+ * @{
+ */
+#ifndef ELECT_MSG_INTERVAL_MAX
+#define ELECT_MSG_INTERVAL_MAX  (4U * ELECT_MSG_INTERVAL)   /**< longest interval of a stable coordinator in ms */
+#endif
+#ifndef ELECT_LEADER_TIMEOUT_MAX
+#define ELECT_LEADER_TIMEOUT_MAX ((ELECT_LEADER_TIMEOUT / ELECT_MSG_INTERVAL) * \
+                                  ELECT_MSG_INTERVAL_MAX)   /**< longest leader timeout of a client in ms */
+#endif
+/** @} */
+
+/**
+ * @name Election algorithms
+ * @{
+ */
+#define ELECT_ALGO_CLASSIC      (0) /**< every higher node answers at once */
+#define ELECT_ALGO_BULLY        (1) /**< answers with suppression timers */
+/** @} */
+
+#ifndef ELECT_ALGO
+/**
+ * @brief Election algorithm in use
+ */
+#define ELECT_ALGO              ELECT_ALGO_CLASSIC
+#endif
+
+/**
+ * @name Parameters for the bully election
+ *
+ * A node hearing the ID of a lower node answers after a backoff, which is
+ * shorter for higher addresses plus some random jitter. The answer is
+ * suppressed if a higher ID is heard in the meantime, so typically only the
+ * highest node answers. Clients never answer, the coordinator does.
+ * @{
+ */
+#define ELECT_BULLY_BACKOFF     (ELECT_MSG_INTERVAL / 4U)   /**< maximum answer backoff in ms */
+#define ELECT_BULLY_JITTER      (ELECT_BULLY_BACKOFF / 8U)  /**< random jitter of backoff in ms */
+#define ELECT_BULLY_THRESHOLD   (2U * ELECT_MSG_INTERVAL)   /**< interval after which a leader is identified */
+/** @} */
+
+#ifndef ELECT_HANDOVER
+/**
+ * @brief Hand over to a higher node instead of starting a new election
+ *
+ * If enabled, a coordinator hearing a higher ID transfers its clients and
+ * moving average to that node and becomes its client, the higher node takes
+ * over at once. Clients follow a higher ID without a new discovery. Set to
+ * 0 to always reset to discovery.
+ */
+#define ELECT_HANDOVER          (1)
+#endif
+
+#ifndef ELECT_CLUSTER
+/**
+ * @brief Two-tier mode, the coordinators of all clusters elect a root
+ *
+ * Every broadcast domain elects its coordinator, the cluster head, as
+ * before. Heads run a second election among themselves over
+ * @ref ELECT_BC_ROOT_ADDR, which has to be forwarded between the clusters,
+ * e.g. by a multicast routing border router. The root polls the summaries of
+ * all clusters and merges them, see cluster.h.
+ */
+#define ELECT_CLUSTER           (0)
+#endif
+
+#if (ELECT_ALGO == ELECT_ALGO_BULLY)
+#define ELECT_THRESHOLD         ELECT_BULLY_THRESHOLD
+#else
+#define ELECT_THRESHOLD         ELECT_LEADER_THRESHOLD
+#endif
+
+/**
+ * @name Membership payload
+ *
+ * Used for batched registrations (PUT `/nodes`) and for the membership
+ * snapshot of the coordinator (GET `/nodes`, block-wise):
+ *
+ *     | version (1) | count (1) | epoch (2) | address (16) x count |
+ *
+ * The epoch changes with every change of the membership on the sender, it
+ * is 0 for registrations of clients. A registration may also be a single
+ * NUL-terminated address string, as sent by older nodes.
+ * @{
+ */
+#define ELECT_NODES_HDR_LEN     (4U)
+#define ELECT_NODES_LEN(n)      (ELECT_NODES_HDR_LEN + ((n) * sizeof(ipv6_addr_t)))
+/** @} */
+
+/**
+ * @name Handover payload
+ *
+ * Sent by an outgoing coordinator with PUT `/handover`, followed by its
+ * clients as membership payload:
+ *
+ *     | version (1) | flags (1) | epoch (2) | average (4) | address (16) |
+ *
+ * Average is the scaled moving average, see ewma.h, it is valid if bit 0 of
+ * flags is set. Address is the one of the outgoing coordinator.
+ * @{
+ */
+#define ELECT_HANDOVER_LEN      (8U + sizeof(ipv6_addr_t))
+#define ELECT_HANDOVER_VALID    (0x01)
+/** @} */
+
+/**
+ * @name Sensor sampling and caching
+ *
+ * Every node samples its sensor periodically and answers requests from the
+ * cached value. Responses carry a CoAP Max-Age, the coordinator reuses a
+ * value until it expires. A client pushes its value to the coordinator and
+ * notifies observers of `/sensor` only if it changed by more than
+ * @ref ELECT_SENSOR_THRESHOLD. The coordinator still polls a client once per
+ * Max-Age, which keeps the leader alive on the client, so Max-Age must be
+ * shorter than @ref ELECT_LEADER_TIMEOUT.
+ *
+ * Sampling runs in its own thread, so a slow conversion never blocks the
+ * network or the main thread. The sensor is read
+ * @ref ELECT_SENSOR_OVERSAMPLE times per interval, the mean of these raw
+ * samples is published and main is notified by @ref ELECT_SENSOR_SAMPLE_EVENT.
+ *
+ * A reading holds one value per channel, see @ref elect_reading_t. Polls,
+ * pushes and summaries carry all channels at once, the election and the
+ * moving average only use @ref ELECT_CHANNEL_TEMP.
+ * @{
+ */
+#define ELECT_CHANNEL_TEMP      (0U)    /**< temperature, degree Celsius x100 */
+#define ELECT_CHANNEL_HUM       (1U)    /**< relative humidity, percent x100 */
+#define ELECT_CHANNEL_NUMOF     (2U)    /**< number of sensor channels */
+#define ELECT_VALUE_NONE        (INT16_MIN) /**< channel without a value */
+/** max. length of a reading as text, incl. separators and terminator */
+#define ELECT_READING_STR_LEN   (ELECT_CHANNEL_NUMOF * 7U)
+#ifndef ELECT_SENSOR_SAMPLE_INTERVAL
+#define ELECT_SENSOR_SAMPLE_INTERVAL    (ELECT_MSG_INTERVAL)    /**< sampling interval in ms, scales with the interval */
+#endif
+#ifndef ELECT_SENSOR_OVERSAMPLE
+#define ELECT_SENSOR_OVERSAMPLE (1U)    /**< raw samples per sampling interval */
+#endif
+#ifndef ELECT_SENSOR_MAX_AGE
+#define ELECT_SENSOR_MAX_AGE    ((3U * ELECT_MSG_INTERVAL) / MS_PER_SEC)    /**< validity of a value in s, scales with the interval */
+#endif
+#ifndef ELECT_SENSOR_THRESHOLD
+#define ELECT_SENSOR_THRESHOLD  (50)    /**< change to push, 0.5 degree Celsius */
+#endif
+#ifndef ELECT_SENSOR_HUM_THRESHOLD
+#define ELECT_SENSOR_HUM_THRESHOLD  (200)   /**< change to push, 2 percent */
+#endif
 /** @} */
 
+#if (ELECT_SENSOR_OVERSAMPLE < 1) || (ELECT_SENSOR_OVERSAMPLE > 16)
+#error "ELECT_SENSOR_OVERSAMPLE must be in [1, 16]"
+#endif
+
+#if ((ELECT_SENSOR_MAX_AGE * MS_PER_SEC) >= ELECT_LEADER_TIMEOUT)
+#error "ELECT_SENSOR_MAX_AGE must be shorter than ELECT_LEADER_TIMEOUT"
+#endif
+
+#ifndef ELECT_WEIGHT
 /**
- * @brief Weight for exponentially weighted moving average
+ * @brief Weight for exponentially weighted moving average, a new value
+ *        counts 1/ELECT_WEIGHT, must be a power of two, see ewma.h
  */
 #define ELECT_WEIGHT            (16)
+#endif
 
 /**
  * @name Broadcast configuration for IDs
@@ -59,6 +240,78 @@ extern "C" {
 #define ELECT_BC_NODEID_WAIT    (5000U)
 /** @} */
 
+/**
+ * @name Filtering of election frames at the listeners
+ *
+ * A listener remembers the last frame of each of the
+ * @ref ELECT_BC_RX_SENDERS senders seen most recently. A repeat of the same
+ * type within @ref ELECT_BC_RX_WINDOW is dropped, unless it is a heartbeat
+ * with a newer sequence number. IDs passing the filter are coalesced per
+ * @ref ELECT_BC_RX_TICK, only the highest of a tick reaches main. So the
+ * load of main is bounded by the number of nodes, not by the packet rate.
+ * The own ID is sent at most once per @ref ELECT_BC_TX_HOLDOFF.
+ * @{
+ */
+#ifndef ELECT_BC_RX_SENDERS
+#define ELECT_BC_RX_SENDERS     (ELECT_NODES_NUM)               /**< senders remembered */
+#endif
+#ifndef ELECT_BC_RX_WINDOW
+#define ELECT_BC_RX_WINDOW      (ELECT_MSG_INTERVAL / 2U)       /**< in ms */
+#endif
+#ifndef ELECT_BC_RX_TICK
+#define ELECT_BC_RX_TICK        (100U)                          /**< in ms */
+#endif
+#ifndef ELECT_BC_TX_HOLDOFF
+#define ELECT_BC_TX_HOLDOFF     (ELECT_MSG_INTERVAL / 4U)       /**< in ms */
+#endif
+/** @} */
+
+#if (ELECT_BC_RX_WINDOW >= ELECT_MSG_INTERVAL)
+#error "ELECT_BC_RX_WINDOW must be shorter than ELECT_MSG_INTERVAL"
+#endif
+
+/**
+ * @name Broadcast configuration for the root election of cluster heads
+ * @{
+ */
+#ifndef ELECT_BC_ROOT_ADDR
+#define ELECT_BC_ROOT_ADDR      {{  0xff, 0x05, 0x00, 0x00, \
+                                    0x00, 0x00, 0x00, 0x00, \
+                                    0x00, 0x00, 0x00, 0x00, \
+                                    0x00, 0x00, 0x24, 0x09 }}  /**< site-local */
+#endif
+#define ELECT_BC_ROOT_PORT      (2411U)
+/** @} */
+
+/**
+ * @name Binary election frame
+ *
+ * Frame layout (all fields in network byte order):
+ *
+ *     | version (1) | type (1) | seq (2) | address (8 or 16) |
+ *
+ * If @ref ELECT_FRAME_FLAG_IID is set in the type byte, the address field
+ * carries only the interface identifier of a `fe80::/64` address. Frames not
+ * starting with @ref ELECT_FRAME_VERSION are parsed as IPv6 address strings,
+ * as sent by older nodes. Define `ELECT_FRAME_TEXT` to send IDs as text
+ * only, for older nodes; heartbeats are not sent then.
+ *
+ * A coordinator sends a heartbeat (@ref ELECT_FRAME_TYPE_ALIVE) with its
+ * address once per interval, so its clients do not depend on its requests
+ * to know it is alive. The sequence number lets clients drop duplicates.
+ * @{
+ */
+#define ELECT_FRAME_VERSION     (0x01)
+#define ELECT_FRAME_HDR_LEN     (4U)
+#define ELECT_FRAME_IID_LEN     (8U)
+#define ELECT_FRAME_MAX_LEN     (ELECT_FRAME_HDR_LEN + sizeof(ipv6_addr_t))
+#define ELECT_FRAME_TYPE_ID     (0x01)  /**< node ID announcement */
+#define ELECT_FRAME_TYPE_SUMMARY (0x02) /**< sensor summary, see below */
+#define ELECT_FRAME_TYPE_ALIVE  (0x03)  /**< leader heartbeat, binary only */
+#define ELECT_FRAME_TYPE_MASK   (0x7f)
+#define ELECT_FRAME_FLAG_IID    (0x80)  /**< address is a link-local IID */
+/** @} */
+
 /**
  * @name Broadcast configuration for sensor values
  * @{
@@ -71,8 +324,34 @@ extern "C" {
 #define ELECT_BC_SENSOR_LEN     (8U)
 /** @} */
 
+/**
+ * @name Sensor summary record
+ *
+ * Sent to `ff02::2017` once per polling round, after the frame header
+ * (type @ref ELECT_FRAME_TYPE_SUMMARY) follow, all as 16 bit in network
+ * byte order:
+ *
+ *     | count | average | mean | median | min | max | extra ... |
+ *
+ * The means of the further channels follow as `extra`, one per channel. A
+ * record of @ref ELECT_SUMMARY_BASE_LEN, from a node with a single channel,
+ * is accepted with all extra channels set to @ref ELECT_VALUE_NONE.
+ *
+ * With `ELECT_FRAME_TEXT` only the average is sent as decimal string.
+ * @{
+ */
+#define ELECT_SUMMARY_BASE_LEN  (ELECT_FRAME_HDR_LEN + 12U)
+#define ELECT_SUMMARY_LEN       (ELECT_SUMMARY_BASE_LEN + \
+                                 (2U * (ELECT_CHANNEL_NUMOF - 1)))
+/** @} */
+
 /**
  * @name IPC message types for events
+ *
+ * Timer events are sent as IPC messages, all others are passed through the
+ * event queue, see evq.h. Broadcast, nodes and sensor events carry a
+ * reference to a receive slot, see rxpool.h. Nodes events carry a binary
+ * address, or no slot to announce a batch, see @ref coap_nodes_take.
  * @{
  */
 #define ELECT_BROADCAST_EVENT           (0x0815)
@@ -82,9 +361,70 @@ extern "C" {
 #define ELECT_LEADER_TIMEOUT_EVENT      (0x0819)
 #define ELECT_NODES_EVENT               (0x0820)
 #define ELECT_SENSOR_EVENT              (0x0821)
+#define ELECT_QUEUE_EVENT               (0x0822)    /**< wakeup, see evq.h */
+#define ELECT_POLL_TIMEOUT_EVENT        (0x0823)
+#define ELECT_POLL_DEADLINE_EVENT       (0x0824)
+#define ELECT_REPLY_EVENT               (0x0825)
+#define ELECT_SENSOR_SAMPLE_EVENT       (0x0826)
+#define ELECT_SENSOR_PUSH_EVENT         (0x0827)
+#define ELECT_NODES_BLOCK_EVENT         (0x0828)
+#define ELECT_HANDOVER_EVENT            (0x0829)
+#define ELECT_ROOT_BROADCAST_EVENT      (0x082a)
+#define ELECT_ROOT_ALIVE_EVENT          (0x082b)
+#define ELECT_HEADS_EVENT               (0x082c)
+#define ELECT_ROOT_SUMMARY_EVENT        (0x082d)
+#define ELECT_POLL_RTO_EVENT            (0x082e)
+#define ELECT_SUMMARY_EVENT             (0x082f)
+#define ELECT_ROOT_TIMER_EVENT          (0x0830)    /**< plus elect_timer_t */
+#define ELECT_CONFIG_EVENT              (0x0838)
+#define ELECT_REGISTER_FAILED_EVENT     (0x0839)
 
 /** @} */
 
+/**
+ * @brief Decoded election frame
+ */
+typedef struct {
+    uint8_t type;       /**< frame type, without flags */
+    uint16_t seq;       /**< sequence number of the sender, 0 for text */
+    ipv6_addr_t addr;   /**< IP address of the sender */
+} elect_frame_t;
+
+/**
+ * @brief State handed over by an outgoing coordinator
+ */
+typedef struct {
+    ipv6_addr_t from;   /**< address of the outgoing coordinator */
+    int32_t average;    /**< scaled moving average, see ewma.h */
+    uint16_t epoch;     /**< membership epoch of the outgoing coordinator */
+    bool valid;         /**< @ref average holds a value */
+} elect_handover_t;
+
+/**
+ * @brief Sensor reading of a node, one value per channel
+ *
+ * Channels without a value are @ref ELECT_VALUE_NONE.
+ */
+typedef struct {
+    int16_t values[ELECT_CHANNEL_NUMOF];    /**< values by channel */
+} elect_reading_t;
+
+/**
+ * @brief Summary of the sensor values of a polling round
+ *
+ * All statistics but @ref extra refer to @ref ELECT_CHANNEL_TEMP.
+ */
+typedef struct {
+    uint16_t count;     /**< number of values in the round */
+    int16_t average;    /**< moving average over all rounds */
+    int16_t mean;       /**< mean of the round */
+    int16_t median;     /**< median of the round */
+    int16_t min;        /**< smallest value of the round */
+    int16_t max;        /**< largest value of the round */
+    /** mean of the round of every further channel, starting at 1 */
+    int16_t extra[ELECT_CHANNEL_NUMOF - 1];
+} elect_summary_t;
+
 /**
  * @brief Init CoAP handlers
  *
@@ -114,40 +454,176 @@ int listen_init(kernel_pid_t main);
 int net_init(kernel_pid_t main);
 
 /**
- * @brief Init sensor
+ * @brief Set the transmit power of the network interface
+ *
+ * @param[in] txpower   power in dBm, the radio may round it
+ *
+ * @returns 0 on success, error otherwise
+ */
+int net_set_txpower(int16_t txpower);
+
+/**
+ * @brief Init sensor and start the sampling thread
+ *
+ * New readings are announced to main as @ref ELECT_SENSOR_SAMPLE_EVENT, the
+ * event queue must be initialised before.
  *
  * @returns 0 on success, error otherwise
  */
 int sensor_init(void);
 
 /**
- * @brief Get temperature sensor value
+ * @brief Get the last published reading of all channels, never blocks
  *
- * @returns Temperature value as degree Celsius x100
+ * @param[out] reading  temperature as degree Celsius x100, humidity as
+ *                      percent x100
  */
-int16_t sensor_read(void);
+void sensor_read(elect_reading_t *reading);
+
+/**
+ * @brief Format a reading as text, decimal values separated by `,`
+ *
+ * A channel without value is left empty, e.g. `2150,` for a missing
+ * humidity.
+ *
+ * @param[out] buf      destination, at least @ref ELECT_READING_STR_LEN
+ * @param[in] reading   reading
+ *
+ * @returns length of the text, without terminator
+ */
+size_t elect_reading_fmt(char *buf, const elect_reading_t *reading);
+
+/**
+ * @brief Parse a reading formatted by @ref elect_reading_fmt
+ *
+ * Missing trailing channels are @ref ELECT_VALUE_NONE, so a single value
+ * of an older node is read as temperature.
+ *
+ * @param[out] reading  reading
+ * @param[in] buf       text
+ * @param[in] len       length of @p buf
+ *
+ * @returns 0 on success, error if the temperature is missing or malformed
+ */
+int elect_reading_parse(elect_reading_t *reading, const char *buf, size_t len);
 
 /**
  * @brief Send IP address via IPv6 multicast to `ff02::1`
  *
+ * The address is sent as binary election frame, see @ref ELECT_FRAME_VERSION.
+ * Within @ref ELECT_BC_TX_HOLDOFF after the last ID nothing is sent.
+ *
  * @param[in] ip    IP address
  *
- * @returns 0 on success, or error otherwise
+ * @returns 0 on success, 1 if suppressed, or error otherwise
  */
 int broadcast_id(const ipv6_addr_t *ip);
 
 /**
- * @brief Send value via IPv6 multicast to `ff02::2017`
+ * @brief Send leader heartbeat via IPv6 multicast to `ff02::1`
+ *
+ * Not sent with `ELECT_FRAME_TEXT`, text frames always carry an ID.
+ *
+ * @param[in] ip    IP address of the leader
+ *
+ * @returns 0 on success, or error otherwise
+ */
+int broadcast_alive(const ipv6_addr_t *ip);
+
+/**
+ * @brief Encode a binary election frame
  *
- * @param[in] value Sensor value
+ * @param[out] buf  destination buffer
+ * @param[in] len   size of @p buf
+ * @param[in] type  frame type
+ * @param[in] seq   sequence number
+ * @param[in] ip    IP address to encode
+ *
+ * @returns length of the frame, 0 if @p buf is too small
+ */
+size_t elect_frame_encode(uint8_t *buf, size_t len, uint8_t type,
+                          uint16_t seq, const ipv6_addr_t *ip);
+
+/**
+ * @brief Decode an election frame, binary or text
+ *
+ * @param[out] frame    decoded frame
+ * @param[in] buf       received data
+ * @param[in] len       length of @p buf
+ *
+ * @returns 0 on success, error otherwise
+ */
+int elect_frame_decode(elect_frame_t *frame, const uint8_t *buf, size_t len);
+
+/**
+ * @brief Send summary of a polling round via IPv6 multicast to `ff02::2017`
+ *
+ * @param[in] summary   summary, see @ref ELECT_SUMMARY_LEN for the format
  *
  * @returns 0 on success, or error otherwise
  */
-int broadcast_sensor(int16_t value);
+int broadcast_summary(const elect_summary_t *summary);
+
+/**
+ * @brief Encode the summary record of a polling round
+ *
+ * @param[out] buf      destination buffer
+ * @param[in] len       size of @p buf
+ * @param[in] seq       sequence number
+ * @param[in] summary   summary
+ *
+ * @returns length of the record, 0 if @p buf is too small
+ */
+size_t elect_summary_encode(uint8_t *buf, size_t len, uint16_t seq,
+                            const elect_summary_t *summary);
+
+/**
+ * @brief Decode the summary record of a polling round
+ *
+ * @param[out] summary  decoded summary
+ * @param[in] buf       received data
+ * @param[in] len       length of @p buf
+ *
+ * @returns 0 on success, error otherwise
+ */
+int elect_summary_decode(elect_summary_t *summary, const uint8_t *buf,
+                         size_t len);
+
+/**
+ * @brief Send own ID to all cluster heads via @ref ELECT_BC_ROOT_ADDR
+ *
+ * Within @ref ELECT_BC_TX_HOLDOFF after the last ID nothing is sent.
+ *
+ * @param[in] ip    routable IP address of this node
+ *
+ * @returns 0 on success, 1 if suppressed, or error otherwise
+ */
+int broadcast_root_id(const ipv6_addr_t *ip);
+
+/**
+ * @brief Send root heartbeat to all cluster heads via @ref ELECT_BC_ROOT_ADDR
+ *
+ * @param[in] ip    routable IP address of this node
+ *
+ * @returns 0 on success, or error otherwise
+ */
+int broadcast_root_alive(const ipv6_addr_t *ip);
+
+/**
+ * @brief Send merged summary of all clusters via @ref ELECT_BC_ROOT_ADDR
+ *
+ * @param[in] summary   summary, see @ref ELECT_SUMMARY_LEN for the format
+ *
+ * @returns 0 on success, or error otherwise
+ */
+int broadcast_root_summary(const elect_summary_t *summary);
 
 /**
  * @brief Send IP address of node to leader node using CoAP PUT
  *
+ * If the leader does not acknowledge the registration,
+ * @ref ELECT_REGISTER_FAILED_EVENT is sent to the main thread.
+ *
  * @param[in] addr  IP address of leader node
  * @param[in] node  IP address of local node
  *
@@ -155,14 +631,157 @@ int broadcast_sensor(int16_t value);
  */
 int coap_put_node(ipv6_addr_t addr, ipv6_addr_t node);
 
+/**
+ * @brief Register several nodes at the leader node using CoAP PUT
+ *
+ * The addresses are sent in as few requests as possible, the leader passes
+ * them to its main thread as batch, see @ref coap_nodes_take.
+ *
+ * @param[in] addr      IP address of leader node
+ * @param[in] nodes     IP addresses of the nodes
+ * @param[in] numof     number of @p nodes
+ * @param[in] epoch     membership epoch of the sender, see
+ *                      @ref ELECT_NODES_HDR_LEN
+ *
+ * @returns 0 on succes, error otherwise
+ */
+int coap_put_nodes(ipv6_addr_t addr, const ipv6_addr_t *nodes,
+                   unsigned numof, uint16_t epoch);
+
+/**
+ * @brief Hand over the coordinator state to a new leader using CoAP PUT
+ *
+ * The leader passes it to its main thread as @ref ELECT_HANDOVER_EVENT,
+ * carrying the decoded @ref elect_handover_t.
+ *
+ * @param[in] addr      IP address of the new leader
+ * @param[in] state     state to hand over
+ *
+ * @returns 0 on succes, error otherwise
+ */
+int coap_put_handover(ipv6_addr_t addr, const elect_handover_t *state);
+
+/**
+ * @brief Fetch the membership snapshot of a node using CoAP GET
+ *
+ * The snapshot is transferred block-wise, for every following block
+ * @ref ELECT_NODES_BLOCK_EVENT is sent to the main thread, which has to
+ * call @ref coap_get_nodes_next. The complete snapshot is passed as one
+ * batch, see @ref coap_nodes_take. If the batch is full, the snapshot is
+ * fetched again by @ref ELECT_NODES_BLOCK_EVENT for block 0.
+ *
+ * @param[in] addr      IP address of the node
+ *
+ * @returns 0 on success, error otherwise
+ */
+int coap_get_nodes(ipv6_addr_t addr);
+
+/**
+ * @brief Request the next block of a snapshot, see @ref coap_get_nodes
+ *
+ * @param[in] blknum    block number, carried by @ref ELECT_NODES_BLOCK_EVENT
+ *
+ * @returns 0 on success, error otherwise
+ */
+int coap_get_nodes_next(uint32_t blknum);
+
+/**
+ * @brief Take the pending membership batch, main thread only
+ *
+ * Registrations and snapshots are appended to a batch per event type, each
+ * payload as a whole or, if the batch is full, not at all. The first
+ * addresses announce the batch as @ref ELECT_NODES_EVENT or
+ * @ref ELECT_HEADS_EVENT without a slot, later ones join it until it is
+ * taken.
+ *
+ * @param[in] event     type of the announcing event
+ * @param[out] nodes    addresses
+ * @param[in] max       max. number of @p nodes, at least @ref ELECT_NODES_NUM
+ *
+ * @returns number of addresses, 0 if no batch of @p event is pending
+ */
+unsigned coap_nodes_take(uint16_t event, ipv6_addr_t *nodes, unsigned max);
+
+/**
+ * @brief Register a cluster head at the root using CoAP PUT to `/heads`
+ *
+ * The root passes it to its main thread as @ref ELECT_HEADS_EVENT.
+ *
+ * @param[in] addr      IP address of the root
+ * @param[in] node      routable IP address of the local node
+ *
+ * @returns 0 on succes, error otherwise
+ */
+int coap_put_head(ipv6_addr_t addr, ipv6_addr_t node);
+
+/**
+ * @brief Get the cluster summary of a head using CoAP GET to `/summary`
+ *
+ * The summary is passed to the main thread as @ref ELECT_ROOT_SUMMARY_EVENT
+ * carrying a decoded @ref elect_summary_t, a failed request as the same
+ * event without a slot.
+ *
+ * @param[in] addr      IP address of the head
+ *
+ * @returns 0 on success, error otherwise
+ */
+int coap_get_summary(ipv6_addr_t addr);
+
+/**
+ * @brief Publish the cluster summary served at GET `/summary`
+ *
+ * @param[in] summary   summary of the last polling round
+ */
+void coap_summary_publish(const elect_summary_t *summary);
+
+/**
+ * @brief Publish the membership snapshot served at GET `/nodes`
+ *
+ * @param[in] nodes     IP addresses of all registered nodes
+ * @param[in] numof     number of @p nodes
+ * @param[in] epoch     membership epoch
+ */
+void coap_nodes_publish(const ipv6_addr_t *nodes, unsigned numof,
+                        uint16_t epoch);
+
 /**
  * @brief Get sensor reading from a node
  *
- * @param[in] addr  IP address of node
+ * The response is passed to the main thread as @ref ELECT_SENSOR_EVENT, a
+ * timeout as @ref ELECT_POLL_TIMEOUT_EVENT carrying the message ID.
+ *
+ * @param[in] addr      IP address of node
+ * @param[out] msg_id   CoAP message ID of the request, may be NULL
  *
  * @returns 0 on success, error otherwise
  */
-int coap_get_sensor(ipv6_addr_t addr);
+int coap_get_sensor(ipv6_addr_t addr, uint16_t *msg_id);
+
+/**
+ * @brief Push a changed sensor reading of the local node to the leader
+ *
+ * Sent as CoAP POST to `/sensor`, the leader passes it to its main thread
+ * as @ref ELECT_SENSOR_PUSH_EVENT and registers an unknown node. An
+ * acknowledged push is sent to the local main thread as
+ * @ref ELECT_LEADER_ALIVE_EVENT, like a poll.
+ *
+ * @param[in] addr      IP address of leader node
+ * @param[in] node      IP address of local node
+ * @param[in] reading   sensor reading, all channels
+ *
+ * @returns 0 on success, error otherwise
+ */
+int coap_push_sensor(ipv6_addr_t addr, ipv6_addr_t node,
+                     const elect_reading_t *reading);
+
+/**
+ * @brief Notify the observers of `/sensor` about a changed reading
+ *
+ * @param[in] reading   sensor reading, all channels
+ *
+ * @returns number of notified observers
+ */
+int coap_notify_sensor(const elect_reading_t *reading);
 
 /**
  * @brief Get link local IP address as string of this node
@@ -172,6 +791,14 @@ int coap_get_sensor(ipv6_addr_t addr);
  */
 void get_node_ip_addr(ipv6_addr_t *addr);
 
+/**
+ * @brief Get a routable IP address of this node, for the root election
+ *
+ * @param[out] addr     first global address, the link local one if there
+ *                      is none
+ */
+void get_node_global_addr(ipv6_addr_t *addr);
+
 /**
  * @brief Compare two IP addresses
  *
@@ -0,0 +1,543 @@
+/*
+ * Copyright (c) 2017 HAW Hamburg
+ *
+ * This file is subject to the terms and conditions of the GNU Lesser
+ * General Public License v2.1. See the file LICENSE in the top level
+ * directory for more details.
+ */
+
+/**
+ * @ingroup     vslab-riot
+ * @{
+ *
+ * @file
+ * @brief       Leader election state machine
+ *
+ * @author      Sebastian Meiling <s@mlng.net>
+ *
+ * @}
+ */
+
+#include <inttypes.h>
+#include <string.h>
+
+#include "log.h"
+
+#include "elect_core.h"
+#include "poll.h"
+
+static const char *_state_str[] = { "discovery", "coordinator", "client" };
+
+/* stretch factors of the defaults, kept when the interval changes at runtime */
+#define INTERVAL_STRETCH    (ELECT_MSG_INTERVAL_MAX / ELECT_MSG_INTERVAL)
+#define TIMEOUT_STRETCH     (ELECT_LEADER_TIMEOUT_MAX / ELECT_LEADER_TIMEOUT)
+
+/* scale a default duration derived from ELECT_MSG_INTERVAL to the runtime one */
+static uint32_t _scale(const elect_core_t *core, uint32_t ms)
+{
+    return (uint32_t)(((uint64_t)ms * core->params.interval) / ELECT_MSG_INTERVAL);
+}
+
+static uint32_t _interval_max(const elect_core_t *core)
+{
+    return core->params.interval * INTERVAL_STRETCH;
+}
+
+static void _election_start(elect_core_t *core)
+{
+    core->stats.start = core->ops->now(core->ctx);
+    core->stats.duration = 0;
+    core->stats.sent = 0;
+    core->stats.received = 0;
+    core->highest_changed = core->stats.start;
+}
+
+static void _election_done(elect_core_t *core, uint8_t state)
+{
+    core->state = state;
+    core->stats.duration = core->ops->now(core->ctx) - core->stats.start;
+    LOG_INFO("elect: converged state=%s time_ms=%" PRIu32 " sent=%u received=%u\n",
+             _state_str[state], core->stats.duration / US_PER_MS,
+             core->stats.sent, core->stats.received);
+}
+
+static void _send_id(elect_core_t *core)
+{
+    int res = core->ops->send_id(core->ctx, &core->addr);
+    if (res < 0) {
+        LOG_ERROR("%s: failed\n", __func__);
+    }
+    else if (res == 0) {
+        /* a frame suppressed by the transport is not counted */
+        core->stats.sent++;
+    }
+}
+
+#if (ELECT_ALGO == ELECT_ALGO_BULLY)
+static void _schedule_reply(elect_core_t *core)
+{
+    if (core->reply_pending) {
+        return;
+    }
+    /* higher addresses answer first and suppress the lower ones */
+    uint32_t rank = 0xff - core->addr.u8[sizeof(ipv6_addr_t) - 1];
+    uint32_t jitter = _scale(core, ELECT_BULLY_JITTER);
+    uint32_t offset = ((_scale(core, ELECT_BULLY_BACKOFF) - jitter) * rank) / 0x100;
+    offset += core->ops->random(core->ctx, jitter);
+    core->ops->timer_set(core->ctx, ELECT_TIMER_REPLY, offset);
+    core->reply_pending = true;
+}
+#endif
+
+static void _cancel_reply(elect_core_t *core)
+{
+    if (core->reply_pending) {
+        core->ops->timer_del(core->ctx, ELECT_TIMER_REPLY);
+        core->reply_pending = false;
+    }
+}
+
+/* fall back to the shortest interval, see ELECT_MSG_INTERVAL_MAX */
+static void _timing_reset(elect_core_t *core)
+{
+    bool stretched = (core->interval > core->params.interval);
+    core->interval = core->params.interval;
+    core->consistent = false;
+    if (stretched && (core->state == ELECT_STATE_COORDINATOR)) {
+        LOG_DEBUG("%s: interval %" PRIu32 " ms\n", __func__, core->interval);
+        core->ops->timer_set(core->ctx, ELECT_TIMER_INTERVAL, core->interval);
+    }
+}
+
+/* leader timeout in ms, scaled with the observed interval of the leader */
+static uint32_t _leader_timeout(const elect_core_t *core)
+{
+    if (core->alive_gap == 0) {
+        return core->params.timeout;
+    }
+    uint32_t gap = core->alive_gap / US_PER_MS;
+    if (gap > _interval_max(core)) {
+        gap = _interval_max(core);
+    }
+    uint32_t timeout = (uint32_t)(((uint64_t)core->params.timeout * gap) /
+                                  core->params.interval);
+    if (timeout < core->params.timeout) {
+        return core->params.timeout;
+    }
+    uint32_t timeout_max = core->params.timeout * TIMEOUT_STRETCH;
+    return (timeout < timeout_max) ? timeout : timeout_max;
+}
+
+static void _reset(elect_core_t *core)
+{
+    LOG_DEBUG("Führe Reset aus\n");
+    LOG_DEBUG("<><><><><><>Bleibe in STATE_DISCOVERY<><><><><><>\n");
+    core->ops->clients_clear(core->ctx);
+    core->ops->timer_del(core->ctx, ELECT_TIMER_TIMEOUT);
+    core->other_higher = false;
+    core->first_round = true;
+    core->leader_alive = true;
+    core->msg_counter = 0;
+    core->interval = core->params.interval;
+    core->alive_last = 0;
+    core->alive_gap = 0;
+    core->alive_seq_valid = false;
+    core->state = ELECT_STATE_DISCOVERY;
+    memset(&core->highest, 0, sizeof(core->highest));
+    ewma_reset(&core->average);
+    aggr_reset(&core->round);
+    _cancel_reply(core);
+    _election_start(core);
+    /* restart the event loop */
+    core->ops->timer_set(core->ctx, ELECT_TIMER_INTERVAL, 0);
+    core->ops->timer_set(core->ctx, ELECT_TIMER_THRESHOLD, 0);
+}
+
+/* register at the leader, repeated on its next heartbeat if this fails */
+static void _register(elect_core_t *core)
+{
+    core->acked = core->ops->now(core->ctx);
+    core->registered = (core->ops->register_at(core->ctx, &core->highest,
+                                               &core->addr) == 0);
+    if (!core->registered) {
+        LOG_ERROR("%s: registration failed\n", __func__);
+    }
+}
+
+#if ELECT_HANDOVER
+/* follow a new leader as client, without a new discovery */
+static void _attach(elect_core_t *core, const ipv6_addr_t *leader)
+{
+    core->ops->clients_clear(core->ctx);
+    _cancel_reply(core);
+    core->highest = *leader;
+    core->other_higher = true;
+    core->leader_alive = true;
+    core->msg_counter = 0;
+    core->interval = core->params.interval;
+    core->alive_last = 0;
+    core->alive_gap = 0;
+    core->alive_seq_valid = false;
+    _election_start(core);
+    _election_done(core, ELECT_STATE_CLIENT);
+    _register(core);
+    core->ops->timer_set(core->ctx, ELECT_TIMER_TIMEOUT, _leader_timeout(core));
+}
+#endif
+
+static void _on_interval(elect_core_t *core)
+{
+    if (core->state == ELECT_STATE_DISCOVERY) {
+        LOG_DEBUG("Current State: STATE_DISCOVERY\n");
+        if (!core->other_higher) {
+            LOG_DEBUG("Broadcaste eigene IP, da keine höherwertigere IP gefunden\n");
+            _send_id(core);
+        }
+        core->ops->timer_set(core->ctx, ELECT_TIMER_INTERVAL, core->params.interval);
+        core->ops->clients_clear(core->ctx);
+    }
+    else if (core->state == ELECT_STATE_COORDINATOR) {
+        LOG_DEBUG("Current State: STATE_COORDINATOR\n");
+        if (core->ops->send_alive(core->ctx, &core->addr) < 0) {
+            LOG_ERROR("%s: heartbeat failed\n", __func__);
+        }
+        LOG_DEBUG("Sammle Sensordaten\n");
+        elect_reading_t own;
+        core->ops->sensor_read(core->ctx, &own);
+        aggr_reset(&core->round);
+        aggr_add_reading(&core->round, &own);
+        core->ops->round_start(core->ctx);
+        core->ops->timer_set(core->ctx, ELECT_TIMER_DEADLINE,
+                             elect_core_deadline(core));
+        if (core->consistent && (core->interval < _interval_max(core))) {
+            core->interval *= 2;
+            if (core->interval > _interval_max(core)) {
+                core->interval = _interval_max(core);
+            }
+            LOG_DEBUG("%s: interval %" PRIu32 " ms\n", __func__, core->interval);
+        }
+        core->consistent = true;
+        core->ops->timer_set(core->ctx, ELECT_TIMER_INTERVAL, core->interval);
+    }
+    core->msg_counter = 0;
+}
+
+static void _on_threshold(elect_core_t *core)
+{
+    if (core->first_round) {
+        core->ops->timer_set(core->ctx, ELECT_TIMER_THRESHOLD, core->params.threshold);
+        core->first_round = false;
+        return;
+    }
+    if (core->state != ELECT_STATE_DISCOVERY) {
+        return;
+    }
+    LOG_DEBUG("msgCounter ist %u\n", core->msg_counter);
+#if (ELECT_ALGO == ELECT_ALGO_BULLY)
+    /* stable, if the highest ID did not change for an interval */
+    bool stable = ((core->ops->now(core->ctx) - core->highest_changed) >=
+                   (core->params.interval * US_PER_MS));
+#else
+    bool stable = (core->msg_counter < 2);
+#endif
+    if (core->other_higher && stable) {
+        LOG_DEBUG("<><><><><><>Wechsle in STATE_CLIENT<><><><><><>\n");
+        _election_done(core, ELECT_STATE_CLIENT);
+        _register(core);
+        core->ops->timer_set(core->ctx, ELECT_TIMER_TIMEOUT, 0);
+        return;
+    }
+    else if (!core->other_higher && stable) {
+        LOG_DEBUG("<><><><><><>Wechsle in STATE_COORDINATOR<><><><><><>\n");
+        _election_done(core, ELECT_STATE_COORDINATOR);
+        if (!ipv6_addr_is_unspecified(&core->highest)) {
+            /* the next lower node may have served as coordinator, take over
+             * its clients instead of waiting for their registration */
+            if (core->ops->fetch_nodes(core->ctx, &core->highest) != 0) {
+                LOG_WARNING("%s: membership fetch failed\n", __func__);
+            }
+        }
+        core->ops->timer_set(core->ctx, ELECT_TIMER_INTERVAL, core->params.interval);
+        return;
+    }
+    LOG_DEBUG("<><><><><><>Bleibe in STATE_DISCOVERY<><><><><><>\n");
+    core->msg_counter = 0;
+    core->ops->timer_set(core->ctx, ELECT_TIMER_THRESHOLD, core->params.threshold);
+}
+
+static void _on_timeout(elect_core_t *core)
+{
+    if (core->state != ELECT_STATE_CLIENT) {
+        return;
+    }
+    if (core->leader_alive) {
+        LOG_DEBUG("COORDINATOR ist aktiv\n");
+        core->leader_alive = false;
+        core->ops->timer_set(core->ctx, ELECT_TIMER_TIMEOUT, _leader_timeout(core));
+    }
+    else {
+        LOG_DEBUG("COORDINATOR ist nicht aktiv\n");
+        LOG_INFO("elect: leader lost\n");
+        _reset(core);
+    }
+}
+
+static void _on_deadline(elect_core_t *core)
+{
+    elect_reading_t readings[ELECT_NODES_NUM];
+    unsigned numof = core->ops->round_finish(core->ctx, readings,
+                                             ELECT_NODES_NUM);
+    if (core->state != ELECT_STATE_COORDINATOR) {
+        return;
+    }
+    for (unsigned i = 0; i < numof; i++) {
+        aggr_add_reading(&core->round, &readings[i]);
+    }
+    elect_summary_t summary;
+    aggr_summary(&core->round, &summary);
+    /* one sample per round, so the weight does not depend on the clients */
+    summary.average = ewma_update(&core->average, summary.mean);
+    LOG_DEBUG("Broadcaste den Mittelwert: %i\n", summary.average);
+    if (core->ops->send_summary(core->ctx, &summary) < 0) {
+        LOG_ERROR("%s: failed\n", __func__);
+    }
+}
+
+static void _on_reply(elect_core_t *core)
+{
+    core->reply_pending = false;
+    if ((core->state == ELECT_STATE_COORDINATOR) ||
+        ((core->state == ELECT_STATE_DISCOVERY) && !core->other_higher)) {
+        _send_id(core);
+    }
+}
+
+void elect_core_init(elect_core_t *core, const ipv6_addr_t *addr,
+                     const elect_core_ops_t *ops, void *ctx)
+{
+    memset(core, 0, sizeof(*core));
+    core->ops = ops;
+    core->ctx = ctx;
+    core->addr = *addr;
+    core->state = ELECT_STATE_DISCOVERY;
+    core->first_round = true;
+    core->leader_alive = true;
+    core->params.interval = ELECT_MSG_INTERVAL;
+    core->params.threshold = ELECT_THRESHOLD;
+    core->params.timeout = ELECT_LEADER_TIMEOUT;
+    core->params.weight_shift = ELECT_WEIGHT_SHIFT;
+}
+
+void elect_core_start(elect_core_t *core)
+{
+    core->interval = core->params.interval;
+    ewma_init(&core->average, core->params.weight_shift);
+    _election_start(core);
+    core->ops->timer_set(core->ctx, ELECT_TIMER_INTERVAL, 0);
+    core->ops->timer_set(core->ctx, ELECT_TIMER_THRESHOLD, 0);
+}
+
+void elect_core_timer(elect_core_t *core, elect_timer_t timer)
+{
+    switch (timer) {
+        case ELECT_TIMER_INTERVAL:
+            _on_interval(core);
+            break;
+        case ELECT_TIMER_THRESHOLD:
+            _on_threshold(core);
+            break;
+        case ELECT_TIMER_TIMEOUT:
+            _on_timeout(core);
+            break;
+        case ELECT_TIMER_DEADLINE:
+            _on_deadline(core);
+            break;
+        case ELECT_TIMER_REPLY:
+            _on_reply(core);
+            break;
+        default:
+            LOG_WARNING("%s: invalid timer (%u)\n", __func__, (unsigned)timer);
+            break;
+    }
+}
+
+void elect_core_id(elect_core_t *core, const ipv6_addr_t *addr)
+{
+    core->stats.received++;
+    if (elect_core_is_lower(&core->addr, addr)) {
+        if (core->state == ELECT_STATE_DISCOVERY) {
+            LOG_DEBUG("höherwertigere IP gefunden.\n");
+            core->other_higher = true;
+            _cancel_reply(core);
+        }
+        else if (core->state == ELECT_STATE_COORDINATOR) {
+            LOG_DEBUG("Höherwertige IP gefunden\n");
+            _timing_reset(core);
+#if ELECT_HANDOVER
+            LOG_INFO("elect: handover\n");
+            if (core->ops->handover(core->ctx, addr, &core->average) != 0) {
+                LOG_ERROR("%s: handover failed\n", __func__);
+            }
+            _attach(core, addr);
+#else
+            _reset(core);
+#endif
+        }
+        else if (core->state == ELECT_STATE_CLIENT) {
+            LOG_DEBUG("Coordinator wechsel\n");
+#if ELECT_HANDOVER
+            /* lower nodes will learn about the leader from its answer */
+            if (elect_core_is_lower(&core->highest, addr)) {
+                _attach(core, addr);
+            }
+#else
+            _reset(core);
+#endif
+        }
+    }
+    else {
+        /* a lower node is looking for its leader */
+        if ((core->state == ELECT_STATE_COORDINATOR) &&
+            (memcmp(&core->addr, addr, sizeof(*addr)) != 0)) {
+            _timing_reset(core);
+        }
+#if (ELECT_ALGO == ELECT_ALGO_BULLY)
+        /* answer once after a backoff, unless a higher node does */
+        if ((core->state != ELECT_STATE_CLIENT) &&
+            (memcmp(&core->addr, addr, sizeof(*addr)) != 0)) {
+            _schedule_reply(core);
+        }
+#else
+        /* broadcast my IP once, so the other node hears me */
+        _send_id(core);
+#endif
+    }
+    if (elect_core_is_lower(&core->highest, addr)) {
+        core->highest = *addr;
+        core->highest_changed = core->ops->now(core->ctx);
+        LOG_DEBUG("neue höchste Addr\n");
+    }
+    core->msg_counter++;
+}
+
+void elect_core_alive(elect_core_t *core)
+{
+    LOG_DEBUG("Nachricht vom Coordinator erhalten\n");
+    core->leader_alive = true;
+    uint32_t now = core->ops->now(core->ctx);
+    if (core->alive_last != 0) {
+        /* follow a longer interval at once, a shorter one slowly */
+        uint32_t gap = now - core->alive_last;
+        core->alive_gap = (gap > core->alive_gap) ? gap
+                                                  : (7 * core->alive_gap + gap) / 8;
+    }
+    core->alive_last = now;
+}
+
+void elect_core_heartbeat(elect_core_t *core, const ipv6_addr_t *addr,
+                          uint16_t seq)
+{
+    if ((core->state != ELECT_STATE_CLIENT) ||
+        (memcmp(&core->highest, addr, sizeof(*addr)) != 0)) {
+        return;
+    }
+    if (core->alive_seq_valid && ((int16_t)(seq - core->alive_seq) <= 0)) {
+        LOG_DEBUG("%s: duplicate (%u)\n", __func__, (unsigned)seq);
+        return;
+    }
+    core->alive_seq = seq;
+    core->alive_seq_valid = true;
+    elect_core_alive(core);
+    /* a leader that does not poll its client has lost the registration */
+    uint32_t silent = core->ops->now(core->ctx) - core->acked;
+    if (!core->registered || (silent > (_leader_timeout(core) * US_PER_MS))) {
+        _register(core);
+    }
+}
+
+void elect_core_acked(elect_core_t *core)
+{
+    elect_core_alive(core);
+    core->acked = core->ops->now(core->ctx);
+}
+
+void elect_core_register_failed(elect_core_t *core)
+{
+    if (core->state == ELECT_STATE_CLIENT) {
+        core->registered = false;
+    }
+}
+
+void elect_core_handover(elect_core_t *core, const ipv6_addr_t *from,
+                         const ewma_t *average)
+{
+#if ELECT_HANDOVER
+    if (core->state == ELECT_STATE_DISCOVERY) {
+        if (core->other_higher || !elect_core_is_lower(from, &core->addr)) {
+            LOG_WARNING("%s: not the highest node, ignored\n", __func__);
+            return;
+        }
+        _cancel_reply(core);
+        _election_done(core, ELECT_STATE_COORDINATOR);
+        core->ops->timer_set(core->ctx, ELECT_TIMER_INTERVAL, 0);
+    }
+    else if (core->state != ELECT_STATE_COORDINATOR) {
+        return;
+    }
+    _timing_reset(core);
+    if (!core->average.valid) {
+        core->average = *average;
+        ewma_rescale(&core->average, core->params.weight_shift);
+    }
+#else
+    (void)core;
+    (void)from;
+    (void)average;
+#endif
+}
+
+void elect_core_node(elect_core_t *core, const ipv6_addr_t *addr)
+{
+    LOG_DEBUG("Clientanmeldung erhalten\n");
+    if (memcmp(&core->addr, addr, sizeof(*addr)) == 0) {
+        /* a snapshot of a former coordinator may list this node */
+        return;
+    }
+    if (core->state == ELECT_STATE_COORDINATOR) {
+        _timing_reset(core);
+    }
+    core->ops->client_add(core->ctx, addr);
+}
+
+void elect_core_configure(elect_core_t *core, const elect_params_t *params)
+{
+    core->params = *params;
+    ewma_rescale(&core->average, params->weight_shift);
+    core->interval = params->interval;
+    core->consistent = false;
+    LOG_INFO("elect: interval=%" PRIu32 " threshold=%" PRIu32 " timeout=%" PRIu32 "\n",
+             params->interval, params->threshold, params->timeout);
+    /* restart the running timers with the new durations */
+    if (core->state == ELECT_STATE_DISCOVERY) {
+        core->ops->timer_set(core->ctx, ELECT_TIMER_INTERVAL, core->interval);
+        if (!core->first_round) {
+            core->ops->timer_set(core->ctx, ELECT_TIMER_THRESHOLD, params->threshold);
+        }
+    }
+    else if (core->state == ELECT_STATE_COORDINATOR) {
+        core->ops->timer_set(core->ctx, ELECT_TIMER_INTERVAL, core->interval);
+    }
+    else if (core->state == ELECT_STATE_CLIENT) {
+        core->ops->timer_set(core->ctx, ELECT_TIMER_TIMEOUT, _leader_timeout(core));
+    }
+}
+
+uint32_t elect_core_deadline(const elect_core_t *core)
+{
+    return _scale(core, ELECT_POLL_DEADLINE);
+}
+
+bool elect_core_is_lower(const ipv6_addr_t *addr1, const ipv6_addr_t *addr2)
+{
+    return (memcmp(addr1, addr2, sizeof(ipv6_addr_t)) < 0);
+}
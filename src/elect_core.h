@@ -0,0 +1,277 @@
+/*
+ * Copyright (c) 2017 HAW Hamburg
+ *
+ * This file is subject to the terms and conditions of the GNU Lesser
+ * General Public License v2.1. See the file LICENSE in the top level
+ * directory for more details.
+ */
+
+/**
+ * @ingroup     vslab-riot
+ * @{
+ *
+ * @file
+ * @brief       Leader election state machine
+ *
+ * The state machine is free of RIOT calls: time, timers, network and sensor
+ * access are injected via @ref elect_core_ops_t. This allows to run it
+ * deterministically on the host, see `src/host`.
+ *
+ * @author      Sebastian Meiling <s@mlng.net>
+ */
+
+#ifndef ELECT_CORE_H
+#define ELECT_CORE_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "aggr.h"
+#include "elect.h"
+#include "ewma.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * @name Node states
+ * @{
+ */
+#define ELECT_STATE_DISCOVERY   (0)
+#define ELECT_STATE_COORDINATOR (1)
+#define ELECT_STATE_CLIENT      (2)
+/** @} */
+
+/**
+ * @brief Timers used by the state machine
+ */
+typedef enum {
+    ELECT_TIMER_INTERVAL = 0,   /**< periodic election and polling interval */
+    ELECT_TIMER_THRESHOLD,      /**< leader identification */
+    ELECT_TIMER_TIMEOUT,        /**< leader liveness */
+    ELECT_TIMER_DEADLINE,       /**< end of a polling round */
+    ELECT_TIMER_REPLY,          /**< backoff of bully answers */
+    ELECT_TIMER_NUMOF
+} elect_timer_t;
+
+/**
+ * @brief Operations the state machine depends on
+ *
+ * All callbacks get the context pointer passed to @ref elect_core_init.
+ */
+typedef struct {
+    /** current time in usec */
+    uint32_t (*now)(void *ctx);
+    /** random number in [0, max) */
+    uint32_t (*random)(void *ctx, uint32_t max);
+    /** (re)schedule @p timer to fire in @p offset ms */
+    void (*timer_set)(void *ctx, elect_timer_t timer, uint32_t offset);
+    /** cancel @p timer */
+    void (*timer_del)(void *ctx, elect_timer_t timer);
+    /** broadcast own ID, returns 0 if sent, >0 if suppressed, <0 on error */
+    int (*send_id)(void *ctx, const ipv6_addr_t *addr);
+    /** broadcast heartbeat of the leader, returns <0 on error */
+    int (*send_alive)(void *ctx, const ipv6_addr_t *addr);
+    /** broadcast summary of a polling round, returns <0 on error */
+    int (*send_summary)(void *ctx, const elect_summary_t *summary);
+    /** register @p node at @p leader, returns 0 on success */
+    int (*register_at)(void *ctx, const ipv6_addr_t *leader,
+                       const ipv6_addr_t *node);
+    /** read all channels of the local sensor */
+    void (*sensor_read)(void *ctx, elect_reading_t *reading);
+    /** fetch the membership snapshot of @p node, returns 0 on success */
+    int (*fetch_nodes)(void *ctx, const ipv6_addr_t *node);
+    /** hand clients and @p average over to @p leader, returns 0 on success */
+    int (*handover)(void *ctx, const ipv6_addr_t *leader, const ewma_t *average);
+    /** add a client to the registry */
+    void (*client_add)(void *ctx, const ipv6_addr_t *addr);
+    /** remove all clients */
+    void (*clients_clear)(void *ctx);
+    /** start polling all clients */
+    void (*round_start)(void *ctx);
+    /** close the polling round, returns number of readings written */
+    unsigned (*round_finish)(void *ctx, elect_reading_t *readings,
+                             unsigned max);
+} elect_core_ops_t;
+
+/**
+ * @brief Statistics of the current election, to compare algorithms
+ */
+typedef struct {
+    uint32_t start;             /**< start of discovery in usec */
+    uint32_t duration;          /**< time to converge in usec */
+    unsigned sent;              /**< IDs sent */
+    unsigned received;          /**< IDs received */
+} elect_core_stats_t;
+
+/**
+ * @brief Timing and averaging parameters, changeable at runtime
+ *
+ * Derived values, e.g. the poll deadline, the bully backoff and the stretched
+ * intervals, scale with @ref interval like their defaults do with
+ * @ref ELECT_MSG_INTERVAL.
+ */
+typedef struct {
+    uint32_t interval;      /**< shortest election interval in ms */
+    uint32_t threshold;     /**< interval after which a leader is identified in ms */
+    uint32_t timeout;       /**< timeout after which a leader is dead in ms */
+    uint8_t weight_shift;   /**< log2 of the weight of the moving average */
+} elect_params_t;
+
+/**
+ * @brief State of the election
+ */
+typedef struct {
+    const elect_core_ops_t *ops;    /**< injected operations */
+    void *ctx;                      /**< context of @ref ops */
+    elect_params_t params;          /**< parameters, may be set before start */
+    ipv6_addr_t addr;               /**< own address */
+    ipv6_addr_t highest;            /**< highest other address seen */
+    uint32_t highest_changed;       /**< time @ref highest changed in usec */
+    elect_core_stats_t stats;       /**< statistics of current election */
+    unsigned msg_counter;           /**< IDs received in current interval */
+    uint32_t interval;              /**< interval of the coordinator in ms */
+    uint32_t alive_last;            /**< last sign of life of the leader in usec */
+    uint32_t alive_gap;             /**< interval of the leader in usec, 0 if unknown */
+    uint16_t alive_seq;             /**< last heartbeat sequence of the leader */
+    ewma_t average;                 /**< moving average of round means */
+    aggr_t round;                   /**< values of current polling round */
+    uint8_t state;                  /**< node state, ELECT_STATE_* */
+    bool other_higher;              /**< a higher address was seen */
+    bool first_round;               /**< threshold not yet started */
+    bool leader_alive;              /**< leader showed up since last check */
+    bool reply_pending;             /**< bully answer scheduled */
+    bool consistent;                /**< no inconsistency in current interval */
+    bool alive_seq_valid;           /**< @ref alive_seq was set */
+    bool registered;                /**< registration at the leader not failed */
+    uint32_t acked;                 /**< last registration, poll or acknowledged
+                                         push in usec */
+} elect_core_t;
+
+/**
+ * @brief Initialise the state machine
+ *
+ * @param[out] core     state to initialise
+ * @param[in] addr      own address
+ * @param[in] ops       injected operations
+ * @param[in] ctx       context passed to @p ops
+ */
+void elect_core_init(elect_core_t *core, const ipv6_addr_t *addr,
+                     const elect_core_ops_t *ops, void *ctx);
+
+/**
+ * @brief Start discovery
+ *
+ * @param[in] core  state
+ */
+void elect_core_start(elect_core_t *core);
+
+/**
+ * @brief Change the parameters of a running state machine
+ *
+ * Running timers are restarted with the new durations, a coordinator falls
+ * back to the shortest interval and the moving average is rescaled.
+ *
+ * @param[in] core      state
+ * @param[in] params    new parameters
+ */
+void elect_core_configure(elect_core_t *core, const elect_params_t *params);
+
+/**
+ * @brief Get the deadline of a polling round
+ *
+ * @param[in] core  state
+ *
+ * @returns deadline in ms, @ref ELECT_POLL_DEADLINE scaled with the interval
+ */
+uint32_t elect_core_deadline(const elect_core_t *core);
+
+/**
+ * @brief Handle an expired timer
+ *
+ * @param[in] core  state
+ * @param[in] timer expired timer
+ */
+void elect_core_timer(elect_core_t *core, elect_timer_t timer);
+
+/**
+ * @brief Handle an ID received from another node
+ *
+ * @param[in] core  state
+ * @param[in] addr  address of the other node
+ */
+void elect_core_id(elect_core_t *core, const ipv6_addr_t *addr);
+
+/**
+ * @brief Handle a sign of life of the leader
+ *
+ * @param[in] core  state
+ */
+void elect_core_alive(elect_core_t *core);
+
+/**
+ * @brief Handle a poll or an acknowledged push of the leader
+ *
+ * Shows that the leader knows this client, see @ref elect_core_heartbeat.
+ *
+ * @param[in] core  state
+ */
+void elect_core_acked(elect_core_t *core);
+
+/**
+ * @brief Handle a heartbeat of a leader
+ *
+ * A client takes the heartbeat of its leader as sign of life, duplicates
+ * and heartbeats of other nodes are ignored. A failed registration is
+ * repeated on the next heartbeat, as is one the leader has apparently lost,
+ * i.e., if it neither polled nor acknowledged a push for a leader timeout.
+ *
+ * @param[in] core  state
+ * @param[in] addr  address of the sender
+ * @param[in] seq   sequence number of the heartbeat
+ */
+void elect_core_heartbeat(elect_core_t *core, const ipv6_addr_t *addr,
+                          uint16_t seq);
+
+/**
+ * @brief Handle a registration not acknowledged by the leader
+ *
+ * @param[in] core  state
+ */
+void elect_core_register_failed(elect_core_t *core);
+
+/**
+ * @brief Handle the registration of a client
+ *
+ * @param[in] core  state
+ * @param[in] addr  address of the client
+ */
+void elect_core_node(elect_core_t *core, const ipv6_addr_t *addr);
+
+/**
+ * @brief Handle the state handed over by an outgoing coordinator
+ *
+ * A node in discovery, which has not seen a higher ID, takes over as
+ * coordinator at once, see @ref ELECT_HANDOVER.
+ *
+ * @param[in] core      state
+ * @param[in] from      address of the outgoing coordinator
+ * @param[in] average   moving average of the outgoing coordinator
+ */
+void elect_core_handover(elect_core_t *core, const ipv6_addr_t *from,
+                         const ewma_t *average);
+
+/**
+ * @brief Compare two addresses, for the election
+ *
+ * @returns true, if @p addr1 is lower than @p addr2
+ */
+bool elect_core_is_lower(const ipv6_addr_t *addr1, const ipv6_addr_t *addr2);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* ELECT_CORE_H */
+/** @} */
@@ -0,0 +1,198 @@
+/*
+ * Copyright (c) 2017 HAW Hamburg
+ *
+ * This file is subject to the terms and conditions of the GNU Lesser
+ * General Public License v2.1. See the file LICENSE in the top level
+ * directory for more details.
+ */
+
+/**
+ * @ingroup     vslab-riot
+ * @{
+ *
+ * @file
+ * @brief       Event queue of the main thread
+ *
+ * @author      Sebastian Meiling <s@mlng.net>
+ *
+ * @}
+ */
+
+#include <string.h>
+
+#include "irq.h"
+#include "log.h"
+#include "msg.h"
+
+#include "evq.h"
+#include "trace.h"
+
+#if (ELECT_EVQ_SIZE & (ELECT_EVQ_SIZE - 1))
+#error "ELECT_EVQ_SIZE must be a power of two"
+#endif
+
+static elect_event_t _ring[ELECT_EVQ_SIZE];
+static unsigned _head;          /* next event to pop */
+static unsigned _tail;          /* next free entry */
+static bool _wakeup_pending;
+static evq_stats_t _stats;
+static kernel_pid_t main_pid = KERNEL_PID_UNDEF;
+
+static unsigned _depth(void)
+{
+    return (_tail - _head) & (2 * ELECT_EVQ_SIZE - 1);
+}
+
+/* events superseded by a later one of their type, all others may have been
+ * acknowledged to their producer already */
+static bool _replaceable(uint16_t type)
+{
+    switch (type) {
+        case ELECT_BROADCAST_EVENT:
+        case ELECT_LEADER_ALIVE_EVENT:
+        case ELECT_POLL_RTO_EVENT:
+        case ELECT_SUMMARY_EVENT:
+        case ELECT_ROOT_BROADCAST_EVENT:
+        case ELECT_ROOT_ALIVE_EVENT:
+            return true;
+        default:
+            return false;
+    }
+}
+
+/* remove the oldest replaceable event, returns false if there is none */
+static bool _drop_replaceable(elect_event_t *dropped)
+{
+    const unsigned mask = 2 * ELECT_EVQ_SIZE - 1;
+    for (unsigned i = _head; i != _tail; i = (i + 1) & mask) {
+        if (!_replaceable(_ring[i % ELECT_EVQ_SIZE].type)) {
+            continue;
+        }
+        *dropped = _ring[i % ELECT_EVQ_SIZE];
+        /* close the gap, the older events move up by one */
+        for (unsigned j = i; j != _head; j = (j - 1) & mask) {
+            _ring[j % ELECT_EVQ_SIZE] = _ring[((j - 1) & mask) % ELECT_EVQ_SIZE];
+        }
+        _head = (_head + 1) & mask;
+        return true;
+    }
+    return false;
+}
+
+void evq_init(kernel_pid_t main)
+{
+    unsigned state = irq_disable();
+    main_pid = main;
+    _head = 0;
+    _tail = 0;
+    _wakeup_pending = false;
+    memset(&_stats, 0, sizeof(_stats));
+    irq_restore(state);
+}
+
+int evq_post(const elect_event_t *ev)
+{
+    elect_event_t dropped = { .kind = ELECT_EVQ_KIND_NONE };
+    bool full = false;
+    bool wakeup = false;
+    int res = 0;
+
+    unsigned state = irq_disable();
+    if (_depth() == ELECT_EVQ_SIZE) {
+        full = true;
+#if (ELECT_EVQ_DROP_POLICY == ELECT_EVQ_DROP_OLDEST)
+        /* @p ev is still added if an older event can be replaced */
+        if (!_drop_replaceable(&dropped)) {
+            dropped = *ev;
+            res = 1;
+        }
+#else
+        dropped = *ev;
+        res = 1;
+#endif
+        _stats.dropped++;
+        TRACE(ELECT_TRACE_EVQ_DROP, 0, NULL, (int16_t)dropped.type);
+    }
+    if (res == 0) {
+        _ring[_tail % ELECT_EVQ_SIZE] = *ev;
+        _tail = (_tail + 1) & (2 * ELECT_EVQ_SIZE - 1);
+        _stats.pushed++;
+    }
+    _stats.depth = _depth();
+    if (_stats.depth > _stats.max_depth) {
+        _stats.max_depth = _stats.depth;
+    }
+    if (!_wakeup_pending) {
+        _wakeup_pending = true;
+        wakeup = true;
+    }
+    irq_restore(state);
+
+    if (full) {
+        LOG_WARNING("%s: queue full, dropped event (%x)\n", __func__,
+                    dropped.type);
+        evq_done(&dropped);
+    }
+    if (wakeup) {
+        msg_t m = { .type = ELECT_QUEUE_EVENT };
+        if (msg_try_send(&m, main_pid) != 1) {
+            /* main drains the queue after every message, so no event is
+             * lost; allow the next producer to try again */
+            _wakeup_pending = false;
+        }
+    }
+    return res;
+}
+
+int evq_post_type(uint16_t type)
+{
+    elect_event_t ev = { .type = type, .kind = ELECT_EVQ_KIND_NONE };
+    return evq_post(&ev);
+}
+
+int evq_post_slot(uint16_t type, rxpool_slot_t *slot)
+{
+    elect_event_t ev = { .type = type, .kind = ELECT_EVQ_KIND_SLOT };
+    ev.data.slot = slot;
+    return evq_post(&ev);
+}
+
+int evq_post_value(uint16_t type, int32_t value)
+{
+    elect_event_t ev = { .type = type, .kind = ELECT_EVQ_KIND_VALUE };
+    ev.data.value = value;
+    return evq_post(&ev);
+}
+
+bool evq_pop(elect_event_t *ev)
+{
+    bool res = false;
+    unsigned state = irq_disable();
+    if (_depth() > 0) {
+        *ev = _ring[_head % ELECT_EVQ_SIZE];
+        _head = (_head + 1) & (2 * ELECT_EVQ_SIZE - 1);
+        _stats.depth = _depth();
+        res = true;
+    }
+    else {
+        /* next producer has to wake us up again */
+        _wakeup_pending = false;
+    }
+    irq_restore(state);
+    return res;
+}
+
+void evq_done(elect_event_t *ev)
+{
+    if ((ev->kind == ELECT_EVQ_KIND_SLOT) && (ev->data.slot != NULL)) {
+        rxpool_release(ev->data.slot);
+    }
+    ev->kind = ELECT_EVQ_KIND_NONE;
+}
+
+void evq_stats(evq_stats_t *stats)
+{
+    unsigned state = irq_disable();
+    *stats = _stats;
+    irq_restore(state);
+}
@@ -0,0 +1,175 @@
+/*
+ * Copyright (c) 2017 HAW Hamburg
+ *
+ * This file is subject to the terms and conditions of the GNU Lesser
+ * General Public License v2.1. See the file LICENSE in the top level
+ * directory for more details.
+ */
+
+/**
+ * @ingroup     vslab-riot
+ * @{
+ *
+ * @file
+ * @brief       Event queue of the main thread
+ *
+ * Bounded multi-producer, single-consumer ring of typed events. Producers,
+ * i.e., the listen thread and the gcoap handlers, never block: if the ring
+ * is full an event is dropped according to @ref ELECT_EVQ_DROP_POLICY. The
+ * main thread is woken by a single @ref ELECT_QUEUE_EVENT message per batch.
+ *
+ * @author      Sebastian Meiling <s@mlng.net>
+ */
+
+#ifndef EVQ_H
+#define EVQ_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "kernel_types.h"
+
+#include "elect.h"
+#include "rxpool.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * @name Drop policies if the event queue is full
+ * @{
+ */
+#define ELECT_EVQ_DROP_NEWEST   (0) /**< reject the event to be added */
+#define ELECT_EVQ_DROP_OLDEST   (1) /**< drop the oldest replaceable event */
+/** @} */
+
+#ifndef ELECT_EVQ_SIZE
+/**
+ * @brief Number of events the queue can hold, must be a power of two
+ */
+#define ELECT_EVQ_SIZE          (32U)
+#endif
+
+#ifndef ELECT_EVQ_DROP_POLICY
+/**
+ * @brief Drop policy of the event queue, newer events are more relevant
+ *        for the election than older ones
+ */
+#define ELECT_EVQ_DROP_POLICY   ELECT_EVQ_DROP_OLDEST
+#endif
+
+/**
+ * @name Payload kinds of an event
+ * @{
+ */
+#define ELECT_EVQ_KIND_NONE     (0) /**< no payload */
+#define ELECT_EVQ_KIND_SLOT     (1) /**< reference to a receive slot */
+#define ELECT_EVQ_KIND_VALUE    (2) /**< integer value */
+/** @} */
+
+/**
+ * @brief Event with typed payload
+ */
+typedef struct {
+    uint16_t type;              /**< event type, see ELECT_*_EVENT */
+    uint8_t kind;               /**< payload kind, see ELECT_EVQ_KIND_* */
+    union {
+        rxpool_slot_t *slot;    /**< slot, owned by the queue or consumer */
+        int32_t value;          /**< integer value */
+    } data;                     /**< payload */
+} elect_event_t;
+
+/**
+ * @brief Backpressure counters of the event queue
+ */
+typedef struct {
+    uint32_t pushed;            /**< events added */
+    uint32_t dropped;           /**< events dropped, because queue was full */
+    uint16_t depth;             /**< current number of queued events */
+    uint16_t max_depth;         /**< high watermark of queued events */
+} evq_stats_t;
+
+/**
+ * @brief Init event queue
+ *
+ * @param[in] main  process ID of main thread, the consumer
+ */
+void evq_init(kernel_pid_t main);
+
+/**
+ * @brief Add event to the queue, never blocks
+ *
+ * A slot reference carried by @p ev is passed to the queue, also if the
+ * event is dropped. Under @ref ELECT_EVQ_DROP_OLDEST a full queue makes room
+ * by dropping the oldest event superseded by later ones of its type, i.e.,
+ * IDs, heartbeats, signs of life, summaries and poll timer ticks. Events
+ * already acknowledged to their producer, e.g. registrations, handovers and
+ * configurations, are never dropped once queued; if there is no replaceable
+ * event, @p ev is dropped instead. An older event dropped to make room for
+ * @p ev is only counted in @ref evq_stats_t::dropped and traced.
+ *
+ * @param[in] ev    event to add
+ *
+ * @returns 0 if @p ev was added, 1 if @p ev was dropped
+ */
+int evq_post(const elect_event_t *ev);
+
+/**
+ * @brief Add event without payload
+ *
+ * @param[in] type  event type
+ *
+ * @returns 0 if the event was added, 1 if it was dropped
+ */
+int evq_post_type(uint16_t type);
+
+/**
+ * @brief Add event carrying a receive slot
+ *
+ * @param[in] type  event type
+ * @param[in] slot  slot, the reference of the caller is passed on
+ *
+ * @returns 0 if the event was added, 1 if it was dropped
+ */
+int evq_post_slot(uint16_t type, rxpool_slot_t *slot);
+
+/**
+ * @brief Add event carrying an integer value
+ *
+ * @param[in] type  event type
+ * @param[in] value payload
+ *
+ * @returns 0 if the event was added, 1 if it was dropped
+ */
+int evq_post_value(uint16_t type, int32_t value);
+
+/**
+ * @brief Take the oldest event from the queue, consumer only
+ *
+ * @param[out] ev   event
+ *
+ * @returns true if an event was taken, false if the queue is empty
+ */
+bool evq_pop(elect_event_t *ev);
+
+/**
+ * @brief Release resources of an event once it is handled
+ *
+ * @param[in] ev    event returned by @ref evq_pop
+ */
+void evq_done(elect_event_t *ev);
+
+/**
+ * @brief Get backpressure counters
+ *
+ * @param[out] stats    counters
+ */
+void evq_stats(evq_stats_t *stats);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* EVQ_H */
+/** @} */
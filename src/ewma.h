@@ -0,0 +1,142 @@
+/*
+ * Copyright (c) 2017 HAW Hamburg
+ *
+ * This file is subject to the terms and conditions of the GNU Lesser
+ * General Public License v2.1. See the file LICENSE in the top level
+ * directory for more details.
+ */
+
+/**
+ * @ingroup     vslab-riot
+ * @{
+ *
+ * @file
+ * @brief       Fixed-point exponentially weighted moving average
+ *
+ * The average is kept scaled by @ref ELECT_WEIGHT, so an update needs one
+ * addition, one subtraction and one shift, no floating point:
+ *
+ *     S(n+1) = S(n) - round(S(n) / W) + x(n+1),    AVG = round(S / W)
+ *
+ * The first sample initialises the average directly (warm start), instead
+ * of slowly converging from zero. The weight defaults to @ref ELECT_WEIGHT
+ * and may be changed at runtime, the sum is rescaled then.
+ *
+ * @author      Sebastian Meiling <s@mlng.net>
+ */
+
+#ifndef EWMA_H
+#define EWMA_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "elect.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#if (ELECT_WEIGHT & (ELECT_WEIGHT - 1)) || (ELECT_WEIGHT < 2) || (ELECT_WEIGHT > 256)
+#error "ELECT_WEIGHT must be a power of two in [2, 256]"
+#endif
+
+/**
+ * @brief log2 of @ref ELECT_WEIGHT
+ */
+#define ELECT_WEIGHT_SHIFT  ((ELECT_WEIGHT >= 256) ? 8 : (ELECT_WEIGHT >= 128) ? 7 : \
+                             (ELECT_WEIGHT >= 64)  ? 6 : (ELECT_WEIGHT >= 32)  ? 5 : \
+                             (ELECT_WEIGHT >= 16)  ? 4 : (ELECT_WEIGHT >= 8)   ? 3 : \
+                             (ELECT_WEIGHT >= 4)   ? 2 : 1)
+
+/**
+ * @brief Moving average state
+ */
+typedef struct {
+    int32_t sum;        /**< average scaled by the weight */
+    uint8_t shift;      /**< log2 of the weight */
+    bool valid;         /**< at least one sample was added */
+} ewma_t;
+
+/**
+ * @brief Clear the average, the next sample is taken as is
+ *
+ * The weight is kept.
+ *
+ * @param[out] ewma average
+ */
+static inline void ewma_reset(ewma_t *ewma)
+{
+    ewma->sum = 0;
+    ewma->valid = false;
+}
+
+/**
+ * @brief Initialise an empty average
+ *
+ * @param[out] ewma     average
+ * @param[in] shift     log2 of the weight, e.g. @ref ELECT_WEIGHT_SHIFT
+ */
+static inline void ewma_init(ewma_t *ewma, uint8_t shift)
+{
+    ewma->shift = shift;
+    ewma_reset(ewma);
+}
+
+/**
+ * @brief Change the weight, keeps the current average
+ *
+ * @param[in,out] ewma  average
+ * @param[in] shift     log2 of the new weight
+ */
+static inline void ewma_rescale(ewma_t *ewma, uint8_t shift)
+{
+    if (shift > ewma->shift) {
+        ewma->sum *= (int32_t)1 << (shift - ewma->shift);
+    }
+    else if (shift < ewma->shift) {
+        /* relies on arithmetic right shift for negative values */
+        ewma->sum >>= (ewma->shift - shift);
+    }
+    ewma->shift = shift;
+}
+
+/**
+ * @brief Get the current average, rounded to nearest
+ *
+ * @param[in] ewma  average
+ *
+ * @returns average, 0 if no sample was added
+ */
+static inline int16_t ewma_get(const ewma_t *ewma)
+{
+    /* relies on arithmetic right shift for negative values */
+    return (int16_t)((ewma->sum + (((int32_t)1 << ewma->shift) >> 1)) >> ewma->shift);
+}
+
+/**
+ * @brief Add a sample
+ *
+ * @param[in,out] ewma  average
+ * @param[in] value     new sample
+ *
+ * @returns updated average
+ */
+static inline int16_t ewma_update(ewma_t *ewma, int16_t value)
+{
+    if (ewma->valid) {
+        ewma->sum += (int32_t)value - ewma_get(ewma);
+    }
+    else {
+        ewma->sum = (int32_t)value * ((int32_t)1 << ewma->shift);
+        ewma->valid = true;
+    }
+    return ewma_get(ewma);
+}
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* EWMA_H */
+/** @} */
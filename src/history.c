@@ -0,0 +1,113 @@
+/*
+ * Copyright (c) 2017 HAW Hamburg
+ *
+ * This file is subject to the terms and conditions of the GNU Lesser
+ * General Public License v2.1. See the file LICENSE in the top level
+ * directory for more details.
+ */
+
+/**
+ * @ingroup     vslab-riot
+ * @{
+ *
+ * @file
+ * @brief       History of the summaries broadcast by the coordinator
+ *
+ * @author      Sebastian Meiling <s@mlng.net>
+ *
+ * @}
+ */
+
+#include "history.h"
+
+#if ELECT_HISTORY
+
+#include "byteorder.h"
+#include "irq.h"
+#include "xtimer.h"
+
+#if (ELECT_HISTORY_NUMOF & (ELECT_HISTORY_NUMOF - 1))
+#error "ELECT_HISTORY_NUMOF must be a power of two"
+#endif
+
+static history_rec_t _ring[ELECT_HISTORY_NUMOF];
+/* records written since boot, the next one goes to _total % NUMOF */
+static uint32_t _total;
+
+static uint32_t _now_ms(void)
+{
+    return (uint32_t)(xtimer_now_usec64() / US_PER_MS);
+}
+
+void history_add(const elect_summary_t *summary)
+{
+    history_rec_t rec = {
+        .time = _now_ms(),
+        .summary = *summary,
+    };
+    unsigned irq = irq_disable();
+    _ring[_total++ % ELECT_HISTORY_NUMOF] = rec;
+    irq_restore(irq);
+}
+
+bool history_get(unsigned i, history_rec_t *rec)
+{
+    bool res = false;
+    unsigned irq = irq_disable();
+    uint32_t numof = (_total < ELECT_HISTORY_NUMOF) ? _total : ELECT_HISTORY_NUMOF;
+    if (i < numof) {
+        *rec = _ring[(_total - numof + i) % ELECT_HISTORY_NUMOF];
+        res = true;
+    }
+    irq_restore(irq);
+    return res;
+}
+
+unsigned history_range(uint32_t since, uint32_t until, unsigned *first)
+{
+    uint32_t now = _now_ms();
+    uint32_t oldest = since * MS_PER_SEC;
+    uint32_t newest = until * MS_PER_SEC;
+    history_rec_t rec;
+    unsigned numof = 0;
+
+    *first = 0;
+    /* records are ordered by time, ages are falling */
+    for (unsigned i = 0; history_get(i, &rec); i++) {
+        uint32_t age = now - rec.time;
+        if ((since > 0) && (age > oldest)) {
+            *first = i + 1;
+            continue;
+        }
+        if (age < newest) {
+            break;
+        }
+        numof++;
+    }
+    return numof;
+}
+
+void history_encode_hdr(uint8_t *buf, unsigned numof)
+{
+    buf[0] = ELECT_HISTORY_VERSION;
+    buf[1] = ELECT_HISTORY_REC_LEN;
+    byteorder_htobebufs(&buf[2], (uint16_t)numof);
+}
+
+void history_encode_rec(uint8_t *buf, const history_rec_t *rec)
+{
+    byteorder_htobebufl(&buf[0], _now_ms() - rec->time);
+    byteorder_htobebufs(&buf[4], rec->summary.count);
+    byteorder_htobebufs(&buf[6], (uint16_t)rec->summary.average);
+    byteorder_htobebufs(&buf[8], (uint16_t)rec->summary.mean);
+    byteorder_htobebufs(&buf[10], (uint16_t)rec->summary.median);
+    byteorder_htobebufs(&buf[12], (uint16_t)rec->summary.min);
+    byteorder_htobebufs(&buf[14], (uint16_t)rec->summary.max);
+    for (unsigned ch = 0; ch < (ELECT_CHANNEL_NUMOF - 1); ch++) {
+        byteorder_htobebufs(&buf[16 + (2 * ch)], (uint16_t)rec->summary.extra[ch]);
+    }
+}
+
+#else
+typedef int dont_be_pedantic;
+#endif /* ELECT_HISTORY */
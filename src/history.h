@@ -0,0 +1,123 @@
+/*
+ * Copyright (c) 2017 HAW Hamburg
+ *
+ * This file is subject to the terms and conditions of the GNU Lesser
+ * General Public License v2.1. See the file LICENSE in the top level
+ * directory for more details.
+ */
+
+/**
+ * @ingroup     vslab-riot
+ * @{
+ *
+ * @file
+ * @brief       History of the summaries broadcast by the coordinator
+ *
+ * Every node listens to the summaries sent to `ff02::2017` and keeps them
+ * with their time of arrival in a static ring, the coordinator adds its own.
+ * The ring is served at GET `/history`, so any node can answer for the
+ * recent values of the cluster. The query `since=<s>` and `until=<s>`
+ * selects records by their age in seconds, records are sent oldest first
+ * and decoded on the host with `tools/history_decode.py`.
+ *
+ * @author      Sebastian Meiling <s@mlng.net>
+ */
+
+#ifndef HISTORY_H
+#define HISTORY_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "elect.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#ifndef ELECT_HISTORY
+/**
+ * @brief Listen to summaries and serve `/history`
+ */
+#define ELECT_HISTORY           (1)
+#endif
+
+#ifndef ELECT_HISTORY_NUMOF
+/**
+ * @brief Number of records in the ring, must be a power of two
+ */
+#define ELECT_HISTORY_NUMOF     (64U)
+#endif
+
+/**
+ * @name Encoding of the ring served at GET `/history`
+ *
+ * Header: version (1), record length (1), number of records (2). Records
+ * follow oldest first: age in ms (4), followed by the summary as in
+ * @ref ELECT_SUMMARY_LEN, count, average, mean, median, min, max and the
+ * means of the further channels (2 each). All numbers are big endian.
+ * @{
+ */
+#define ELECT_HISTORY_VERSION   (0x02)
+#define ELECT_HISTORY_HDR_LEN   (4U)
+#define ELECT_HISTORY_REC_LEN   (16U + (2U * (ELECT_CHANNEL_NUMOF - 1)))
+/** @} */
+
+/**
+ * @brief History record
+ */
+typedef struct {
+    uint32_t time;              /**< time of arrival in ms */
+    elect_summary_t summary;    /**< received summary */
+} history_rec_t;
+
+/**
+ * @brief Add a summary to the ring, the oldest one is overwritten
+ *
+ * @param[in] summary   summary of a polling round
+ */
+void history_add(const elect_summary_t *summary);
+
+/**
+ * @brief Find the records in a range of ages
+ *
+ * @param[in] since     max. age in s, 0 for all records
+ * @param[in] until     min. age in s
+ * @param[out] first    index of the first matching record
+ *
+ * @returns number of matching records, starting at @p first
+ */
+unsigned history_range(uint32_t since, uint32_t until, unsigned *first);
+
+/**
+ * @brief Get a record of the ring
+ *
+ * @param[in] i         index, 0 is the oldest record
+ * @param[out] rec      record
+ *
+ * @returns true on success, false if there is no record @p i
+ */
+bool history_get(unsigned i, history_rec_t *rec);
+
+/**
+ * @brief Encode the header of a range
+ *
+ * @param[out] buf      destination, at least @ref ELECT_HISTORY_HDR_LEN bytes
+ * @param[in] numof     number of records that follow
+ */
+void history_encode_hdr(uint8_t *buf, unsigned numof);
+
+/**
+ * @brief Encode a record with its current age
+ *
+ * @param[out] buf      destination, at least @ref ELECT_HISTORY_REC_LEN bytes
+ * @param[in] rec       record
+ */
+void history_encode_rec(uint8_t *buf, const history_rec_t *rec);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* HISTORY_H */
+/** @} */
@@ -0,0 +1,326 @@
+/*
+ * Copyright (c) 2017 HAW Hamburg
+ *
+ * This file is subject to the terms and conditions of the GNU Lesser
+ * General Public License v2.1. See the file LICENSE in the top level
+ * directory for more details.
+ */
+
+/**
+ * @ingroup     vslab-riot
+ * @{
+ *
+ * @file
+ * @brief       Host microbenchmarks of the election core
+ *
+ * The election state machine runs against a virtual clock and a transport
+ * that only counts messages, so results do not depend on a network.
+ *
+ * @author      Sebastian Meiling <s@mlng.net>
+ *
+ * @}
+ */
+
+#define _POSIX_C_SOURCE 199309L
+
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "elect_core.h"
+
+#define BENCH_ITERATIONS    (1000000U)
+#define BENCH_NODES         (64U)
+
+typedef struct {
+    uint32_t now;
+    uint32_t timers[ELECT_TIMER_NUMOF];
+    uint32_t armed;
+    unsigned sent;
+    uint32_t seed;
+} sim_t;
+
+static volatile int32_t _sink;
+
+static uint32_t _sim_now(void *ctx)
+{
+    return ((sim_t *)ctx)->now;
+}
+
+static uint32_t _sim_random(void *ctx, uint32_t max)
+{
+    sim_t *sim = ctx;
+    /* xorshift32, deterministic across runs */
+    sim->seed ^= sim->seed << 13;
+    sim->seed ^= sim->seed >> 17;
+    sim->seed ^= sim->seed << 5;
+    return (max > 0) ? (sim->seed % max) : 0;
+}
+
+static void _sim_timer_set(void *ctx, elect_timer_t timer, uint32_t offset)
+{
+    sim_t *sim = ctx;
+    sim->timers[timer] = sim->now + (offset * US_PER_MS);
+    sim->armed |= (1U << timer);
+}
+
+static void _sim_timer_del(void *ctx, elect_timer_t timer)
+{
+    ((sim_t *)ctx)->armed &= ~(1U << timer);
+}
+
+static int _sim_send_id(void *ctx, const ipv6_addr_t *addr)
+{
+    (void)addr;
+    ((sim_t *)ctx)->sent++;
+    return 0;
+}
+
+static int _sim_send_alive(void *ctx, const ipv6_addr_t *addr)
+{
+    (void)addr;
+    ((sim_t *)ctx)->sent++;
+    return 0;
+}
+
+static int _sim_send_summary(void *ctx, const elect_summary_t *summary)
+{
+    (void)summary;
+    ((sim_t *)ctx)->sent++;
+    return 0;
+}
+
+static int _sim_register_at(void *ctx, const ipv6_addr_t *leader,
+                            const ipv6_addr_t *node)
+{
+    (void)leader;
+    (void)node;
+    ((sim_t *)ctx)->sent++;
+    return 0;
+}
+
+static int _sim_fetch_nodes(void *ctx, const ipv6_addr_t *node)
+{
+    (void)node;
+    ((sim_t *)ctx)->sent++;
+    return 0;
+}
+
+static int _sim_handover(void *ctx, const ipv6_addr_t *leader,
+                         const ewma_t *average)
+{
+    (void)leader;
+    (void)average;
+    ((sim_t *)ctx)->sent++;
+    return 0;
+}
+
+static void _sim_sensor_read(void *ctx, elect_reading_t *reading)
+{
+    reading->values[ELECT_CHANNEL_TEMP] = (int16_t)(1800 + _sim_random(ctx, 1000));
+    reading->values[ELECT_CHANNEL_HUM] = (int16_t)(3000 + _sim_random(ctx, 5000));
+}
+
+static void _sim_client_add(void *ctx, const ipv6_addr_t *addr)
+{
+    (void)ctx;
+    (void)addr;
+}
+
+static void _sim_clients_clear(void *ctx)
+{
+    (void)ctx;
+}
+
+static void _sim_round_start(void *ctx)
+{
+    (void)ctx;
+}
+
+static unsigned _sim_round_finish(void *ctx, elect_reading_t *readings,
+                                  unsigned max)
+{
+    unsigned n = (max < 8) ? max : 8;
+    for (unsigned i = 0; i < n; i++) {
+        _sim_sensor_read(ctx, &readings[i]);
+    }
+    return n;
+}
+
+static const elect_core_ops_t _sim_ops = {
+    .now = _sim_now,
+    .random = _sim_random,
+    .timer_set = _sim_timer_set,
+    .timer_del = _sim_timer_del,
+    .send_id = _sim_send_id,
+    .send_alive = _sim_send_alive,
+    .send_summary = _sim_send_summary,
+    .register_at = _sim_register_at,
+    .sensor_read = _sim_sensor_read,
+    .fetch_nodes = _sim_fetch_nodes,
+    .handover = _sim_handover,
+    .client_add = _sim_client_add,
+    .clients_clear = _sim_clients_clear,
+    .round_start = _sim_round_start,
+    .round_finish = _sim_round_finish,
+};
+
+/* fire all timers due at the current virtual time */
+static void _sim_run_timers(sim_t *sim, elect_core_t *core)
+{
+    for (unsigned t = 0; t < ELECT_TIMER_NUMOF; t++) {
+        if ((sim->armed & (1U << t)) &&
+            ((int32_t)(sim->now - sim->timers[t]) >= 0)) {
+            sim->armed &= ~(1U << t);
+            elect_core_timer(core, (elect_timer_t)t);
+        }
+    }
+}
+
+static void _make_addr(ipv6_addr_t *addr, uint32_t id)
+{
+    memset(addr, 0, sizeof(*addr));
+    addr->u8[0] = 0xfe;
+    addr->u8[1] = 0x80;
+    addr->u8[12] = (uint8_t)(id >> 24);
+    addr->u8[13] = (uint8_t)(id >> 16);
+    addr->u8[14] = (uint8_t)(id >> 8);
+    addr->u8[15] = (uint8_t)id;
+}
+
+static double _elapsed(const struct timespec *start)
+{
+    struct timespec end;
+    clock_gettime(CLOCK_MONOTONIC, &end);
+    return (double)(end.tv_sec - start->tv_sec) +
+           (double)(end.tv_nsec - start->tv_nsec) / 1e9;
+}
+
+static void _report(const char *name, unsigned ops, double secs)
+{
+    printf("%-28s %10.1f ns/op %14.0f ops/s\n", name,
+           (secs * 1e9) / ops, ops / secs);
+}
+
+static void bench_events(void)
+{
+    sim_t sim = { .seed = 0x2409 };
+    elect_core_t core;
+    ipv6_addr_t addrs[BENCH_NODES];
+    struct timespec start;
+
+    for (unsigned i = 0; i < BENCH_NODES; i++) {
+        _make_addr(&addrs[i], i + 1);
+    }
+    elect_core_init(&core, &addrs[BENCH_NODES / 2], &_sim_ops, &sim);
+    elect_core_start(&core);
+
+    clock_gettime(CLOCK_MONOTONIC, &start);
+    for (unsigned i = 0; i < BENCH_ITERATIONS; i++) {
+        /* one ID per virtual millisecond, from random nodes */
+        sim.now += US_PER_MS;
+        elect_core_id(&core, &addrs[_sim_random(&sim, BENCH_NODES)]);
+        _sim_run_timers(&sim, &core);
+    }
+    _report("state machine events", BENCH_ITERATIONS, _elapsed(&start));
+    printf("%-28s %10u\n", "  messages sent", sim.sent);
+}
+
+static void bench_addr_cmp(void)
+{
+    ipv6_addr_t addrs[BENCH_NODES];
+    struct timespec start;
+    int32_t res = 0;
+
+    for (unsigned i = 0; i < BENCH_NODES; i++) {
+        _make_addr(&addrs[i], (i * 2654435761U) >> 8);
+    }
+    clock_gettime(CLOCK_MONOTONIC, &start);
+    for (unsigned i = 0; i < BENCH_ITERATIONS; i++) {
+        res += elect_core_is_lower(&addrs[i % BENCH_NODES],
+                                   &addrs[(i + 1) % BENCH_NODES]);
+    }
+    _sink = res;
+    _report("address comparison", BENCH_ITERATIONS, _elapsed(&start));
+}
+
+/* previous floating point implementation, for reference */
+static int16_t _average_double(int16_t average, int16_t value)
+{
+    return (int16_t)((double)((((16.0 - 1.0) / 16.0) * (double)average) +
+                              ((1.0 / 16.0) * (double)value)));
+}
+
+static void bench_average(void)
+{
+    struct timespec start;
+    int16_t avg = 0;
+    ewma_t ewma;
+
+    clock_gettime(CLOCK_MONOTONIC, &start);
+    for (unsigned i = 0; i < BENCH_ITERATIONS; i++) {
+        avg = _average_double(avg, (int16_t)(1800 + (i & 0x3ff)));
+    }
+    _sink = avg;
+    _report("moving average (double)", BENCH_ITERATIONS, _elapsed(&start));
+
+    ewma_init(&ewma, ELECT_WEIGHT_SHIFT);
+    clock_gettime(CLOCK_MONOTONIC, &start);
+    for (unsigned i = 0; i < BENCH_ITERATIONS; i++) {
+        avg = ewma_update(&ewma, (int16_t)(1800 + (i & 0x3ff)));
+    }
+    _sink = avg;
+    _report("moving average (fixed)", BENCH_ITERATIONS, _elapsed(&start));
+
+    /* deviation from an exact average, the double version truncates */
+    double exact = 1800.0;
+    int err_double = 0;
+    int err_fixed = 0;
+    avg = 1800;
+    ewma_init(&ewma, ELECT_WEIGHT_SHIFT);
+    for (unsigned i = 0; i < BENCH_ITERATIONS; i++) {
+        int16_t value = (int16_t)(1800 + (i & 0x3ff));
+        exact += (value - exact) / ELECT_WEIGHT;
+        avg = _average_double(avg, value);
+        ewma_update(&ewma, value);
+        int d = abs(avg - (int)(exact + 0.5));
+        int f = abs(ewma_get(&ewma) - (int)(exact + 0.5));
+        err_double = (d > err_double) ? d : err_double;
+        err_fixed = (f > err_fixed) ? f : err_fixed;
+    }
+    printf("%-28s %10d\n", "  max error (double)", err_double);
+    printf("%-28s %10d\n", "  max error (fixed)", err_fixed);
+}
+
+static void bench_aggr(void)
+{
+    struct timespec start;
+    aggr_t aggr;
+    elect_summary_t summary;
+    int32_t res = 0;
+
+    clock_gettime(CLOCK_MONOTONIC, &start);
+    for (unsigned i = 0; i < BENCH_ITERATIONS / ELECT_AGGR_NUMOF; i++) {
+        aggr_reset(&aggr);
+        for (unsigned j = 0; j < ELECT_AGGR_NUMOF; j++) {
+            aggr_add(&aggr, (int16_t)(1800 + (((i + j) * 2654435761U) >> 22)));
+        }
+        aggr_summary(&aggr, &summary);
+        res += summary.median;
+    }
+    _sink = res;
+    _report("round summary (per value)",
+            (BENCH_ITERATIONS / ELECT_AGGR_NUMOF) * ELECT_AGGR_NUMOF,
+            _elapsed(&start));
+}
+
+int main(void)
+{
+    bench_events();
+    bench_addr_cmp();
+    bench_average();
+    bench_aggr();
+    return 0;
+}
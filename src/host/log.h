@@ -0,0 +1,57 @@
+/*
+ * Copyright (c) 2017 HAW Hamburg
+ *
+ * This file is subject to the terms and conditions of the GNU Lesser
+ * General Public License v2.1. See the file LICENSE in the top level
+ * directory for more details.
+ */
+
+/**
+ * @ingroup     vslab-riot
+ * @{
+ *
+ * @file
+ * @brief       Host replacement of RIOT's log.h
+ *
+ * @author      Sebastian Meiling <s@mlng.net>
+ */
+
+#ifndef LOG_H
+#define LOG_H
+
+#include <stdio.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * @brief Log levels, same as in RIOT
+ */
+enum {
+    LOG_NONE,
+    LOG_ERROR,
+    LOG_WARNING,
+    LOG_INFO,
+    LOG_DEBUG,
+    LOG_ALL
+};
+
+#ifndef LOG_LEVEL
+#define LOG_LEVEL       LOG_WARNING
+#endif
+
+#define LOG(level, ...) do { \
+        if ((level) <= LOG_LEVEL) { printf(__VA_ARGS__); } } while (0U)
+
+#define LOG_ERROR(...)      LOG(LOG_ERROR, __VA_ARGS__)
+#define LOG_WARNING(...)    LOG(LOG_WARNING, __VA_ARGS__)
+#define LOG_INFO(...)       LOG(LOG_INFO, __VA_ARGS__)
+#define LOG_DEBUG(...)      LOG(LOG_DEBUG, __VA_ARGS__)
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* LOG_H */
+/** @} */
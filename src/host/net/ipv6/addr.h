@@ -0,0 +1,56 @@
+/*
+ * Copyright (c) 2017 HAW Hamburg
+ *
+ * This file is subject to the terms and conditions of the GNU Lesser
+ * General Public License v2.1. See the file LICENSE in the top level
+ * directory for more details.
+ */
+
+/**
+ * @ingroup     vslab-riot
+ * @{
+ *
+ * @file
+ * @brief       Host replacement of RIOT's net/ipv6/addr.h
+ *
+ * @author      Sebastian Meiling <s@mlng.net>
+ */
+
+#ifndef NET_IPV6_ADDR_H
+#define NET_IPV6_ADDR_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define IPV6_ADDR_MAX_STR_LEN   (sizeof("ffff:ffff:ffff:ffff:ffff:ffff:255.255.255.255"))
+
+#define IPV6_ADDR_ALL_NODES_LINK_LOCAL {{ 0xff, 0x02, 0x00, 0x00, \
+                                          0x00, 0x00, 0x00, 0x00, \
+                                          0x00, 0x00, 0x00, 0x00, \
+                                          0x00, 0x00, 0x00, 0x01 }}
+
+/**
+ * @brief IPv6 address, same layout as in RIOT
+ */
+typedef union {
+    uint8_t u8[16];
+    uint16_t u16[8];
+    uint32_t u32[4];
+    uint64_t u64[2];
+} ipv6_addr_t;
+
+static inline bool ipv6_addr_is_unspecified(const ipv6_addr_t *addr)
+{
+    return (addr->u64[0] == 0) && (addr->u64[1] == 0);
+}
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* NET_IPV6_ADDR_H */
+/** @} */
@@ -0,0 +1,466 @@
+/*
+ * Copyright (c) 2017 HAW Hamburg
+ *
+ * This file is subject to the terms and conditions of the GNU Lesser
+ * General Public License v2.1. See the file LICENSE in the top level
+ * directory for more details.
+ */
+
+/**
+ * @ingroup     vslab-riot
+ * @{
+ *
+ * @file
+ * @brief       Host unit tests of the election core
+ *
+ * The state machine runs against a virtual clock, the transport records the
+ * last registration and handover instead of sending. Exits non-zero if a
+ * check fails.
+ *
+ * @author      Sebastian Meiling <s@mlng.net>
+ *
+ * @}
+ */
+
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "elect_core.h"
+
+#define CHECK(cond)     _check((cond), #cond, __LINE__)
+
+typedef struct {
+    uint32_t now;
+    uint32_t timers[ELECT_TIMER_NUMOF];
+    uint32_t armed;
+    unsigned ids_sent;
+    bool suppress;
+    unsigned registered;
+    bool drop_register;
+    bool known;
+    unsigned handovers;
+    ipv6_addr_t leader;
+} sim_t;
+
+static unsigned _failed;
+static unsigned _checked;
+
+static void _check(bool ok, const char *cond, int line)
+{
+    _checked++;
+    if (!ok) {
+        _failed++;
+        printf("test.c:%d: FAILED: %s\n", line, cond);
+    }
+}
+
+static uint32_t _sim_now(void *ctx)
+{
+    return ((sim_t *)ctx)->now;
+}
+
+static uint32_t _sim_random(void *ctx, uint32_t max)
+{
+    (void)ctx;
+    return max / 2;
+}
+
+static void _sim_timer_set(void *ctx, elect_timer_t timer, uint32_t offset)
+{
+    sim_t *sim = ctx;
+    sim->timers[timer] = sim->now + (offset * US_PER_MS);
+    sim->armed |= (1U << timer);
+}
+
+static void _sim_timer_del(void *ctx, elect_timer_t timer)
+{
+    ((sim_t *)ctx)->armed &= ~(1U << timer);
+}
+
+static int _sim_send_id(void *ctx, const ipv6_addr_t *addr)
+{
+    sim_t *sim = ctx;
+    (void)addr;
+    if (sim->suppress) {
+        return 1;
+    }
+    sim->ids_sent++;
+    return 0;
+}
+
+static int _sim_send_alive(void *ctx, const ipv6_addr_t *addr)
+{
+    (void)ctx;
+    (void)addr;
+    return 0;
+}
+
+static int _sim_send_summary(void *ctx, const elect_summary_t *summary)
+{
+    (void)ctx;
+    (void)summary;
+    return 0;
+}
+
+static int _sim_register_at(void *ctx, const ipv6_addr_t *leader,
+                            const ipv6_addr_t *node)
+{
+    sim_t *sim = ctx;
+    (void)node;
+    sim->registered++;
+    sim->leader = *leader;
+    /* a dropped request leaves the leader unaware of the client */
+    sim->known = !sim->drop_register;
+    sim->drop_register = false;
+    return 0;
+}
+
+static int _sim_fetch_nodes(void *ctx, const ipv6_addr_t *node)
+{
+    (void)ctx;
+    (void)node;
+    return 0;
+}
+
+static int _sim_handover(void *ctx, const ipv6_addr_t *leader,
+                         const ewma_t *average)
+{
+    (void)leader;
+    (void)average;
+    ((sim_t *)ctx)->handovers++;
+    return 0;
+}
+
+static void _sim_sensor_read(void *ctx, elect_reading_t *reading)
+{
+    (void)ctx;
+    reading->values[ELECT_CHANNEL_TEMP] = 2000;
+    reading->values[ELECT_CHANNEL_HUM] = 5000;
+}
+
+static void _sim_client_add(void *ctx, const ipv6_addr_t *addr)
+{
+    (void)ctx;
+    (void)addr;
+}
+
+static void _sim_clients_clear(void *ctx)
+{
+    (void)ctx;
+}
+
+static void _sim_round_start(void *ctx)
+{
+    (void)ctx;
+}
+
+static unsigned _sim_round_finish(void *ctx, elect_reading_t *readings,
+                                  unsigned max)
+{
+    (void)ctx;
+    (void)readings;
+    (void)max;
+    return 0;
+}
+
+static const elect_core_ops_t _sim_ops = {
+    .now = _sim_now,
+    .random = _sim_random,
+    .timer_set = _sim_timer_set,
+    .timer_del = _sim_timer_del,
+    .send_id = _sim_send_id,
+    .send_alive = _sim_send_alive,
+    .send_summary = _sim_send_summary,
+    .register_at = _sim_register_at,
+    .sensor_read = _sim_sensor_read,
+    .fetch_nodes = _sim_fetch_nodes,
+    .handover = _sim_handover,
+    .client_add = _sim_client_add,
+    .clients_clear = _sim_clients_clear,
+    .round_start = _sim_round_start,
+    .round_finish = _sim_round_finish,
+};
+
+static void _make_addr(ipv6_addr_t *addr, uint8_t id)
+{
+    memset(addr, 0, sizeof(*addr));
+    addr->u8[0] = 0xfe;
+    addr->u8[1] = 0x80;
+    addr->u8[15] = id;
+}
+
+/* advance the virtual clock by @p ms, the node @p peer announces itself once
+ * per interval while the core is in discovery, like a coordinator answers */
+static void _sim_run(sim_t *sim, elect_core_t *core, uint32_t ms,
+                     const ipv6_addr_t *peer)
+{
+    for (uint32_t i = 0; i < ms; i++) {
+        sim->now += US_PER_MS;
+        for (unsigned t = 0; t < ELECT_TIMER_NUMOF; t++) {
+            if ((sim->armed & (1U << t)) &&
+                ((int32_t)(sim->now - sim->timers[t]) >= 0)) {
+                sim->armed &= ~(1U << t);
+                elect_core_timer(core, (elect_timer_t)t);
+            }
+        }
+        if ((peer != NULL) && (core->state == ELECT_STATE_DISCOVERY) &&
+            ((sim->now / US_PER_MS) % ELECT_MSG_INTERVAL == 1)) {
+            elect_core_id(core, peer);
+        }
+    }
+}
+
+static void _start(sim_t *sim, elect_core_t *core, uint8_t id)
+{
+    ipv6_addr_t addr;
+    memset(sim, 0, sizeof(*sim));
+    _make_addr(&addr, id);
+    elect_core_init(core, &addr, &_sim_ops, sim);
+    elect_core_start(core);
+}
+
+/* time until a discovery has converged */
+#define TEST_CONVERGE_MS    (ELECT_THRESHOLD + (2 * ELECT_MSG_INTERVAL))
+
+static void test_discovery_coordinator(void)
+{
+    sim_t sim;
+    elect_core_t core;
+    _start(&sim, &core, 2);
+    CHECK(core.state == ELECT_STATE_DISCOVERY);
+    _sim_run(&sim, &core, TEST_CONVERGE_MS, NULL);
+    CHECK(core.state == ELECT_STATE_COORDINATOR);
+    CHECK(sim.ids_sent > 0);
+    CHECK(sim.registered == 0);
+}
+
+static void test_sent_suppressed(void)
+{
+    sim_t sim;
+    elect_core_t core;
+    _start(&sim, &core, 2);
+    CHECK(core.stats.sent == sim.ids_sent);
+    /* IDs held back by the transport do not count as sent */
+    sim.suppress = true;
+    _sim_run(&sim, &core, TEST_CONVERGE_MS, NULL);
+    CHECK(core.state == ELECT_STATE_COORDINATOR);
+    CHECK(core.stats.sent == sim.ids_sent);
+}
+
+static void test_discovery_client(void)
+{
+    sim_t sim;
+    elect_core_t core;
+    ipv6_addr_t higher;
+    _make_addr(&higher, 3);
+    _start(&sim, &core, 2);
+    _sim_run(&sim, &core, TEST_CONVERGE_MS, &higher);
+    CHECK(core.state == ELECT_STATE_CLIENT);
+    CHECK(sim.registered == 1);
+    CHECK(memcmp(&sim.leader, &higher, sizeof(higher)) == 0);
+}
+
+static void test_register_retry(void)
+{
+    sim_t sim;
+    elect_core_t core;
+    ipv6_addr_t higher;
+    _make_addr(&higher, 3);
+    _start(&sim, &core, 2);
+    _sim_run(&sim, &core, TEST_CONVERGE_MS, &higher);
+    CHECK(sim.registered == 1);
+    /* a rejected registration is repeated on the next heartbeat only */
+    elect_core_register_failed(&core);
+    CHECK(sim.registered == 1);
+    elect_core_heartbeat(&core, &higher, 1);
+    CHECK(sim.registered == 2);
+    elect_core_heartbeat(&core, &higher, 2);
+    CHECK(sim.registered == 2);
+}
+
+static void test_register_lost(void)
+{
+    sim_t sim;
+    elect_core_t core;
+    ipv6_addr_t higher;
+    _make_addr(&higher, 3);
+    _start(&sim, &core, 2);
+    sim.drop_register = true;
+    _sim_run(&sim, &core, TEST_CONVERGE_MS, &higher);
+    CHECK(sim.registered == 1);
+    CHECK(!sim.known);
+    /* the leader sends heartbeats, but polls only the clients it knows */
+    unsigned polls = 0;
+    for (unsigned i = 0; i < 2 * (ELECT_LEADER_TIMEOUT / ELECT_MSG_INTERVAL); i++) {
+        elect_core_heartbeat(&core, &higher, (uint16_t)(i + 1));
+        if (sim.known) {
+            elect_core_acked(&core);
+            polls++;
+        }
+        _sim_run(&sim, &core, ELECT_MSG_INTERVAL, NULL);
+    }
+    CHECK(core.state == ELECT_STATE_CLIENT);
+    CHECK(sim.known);
+    CHECK(polls > 0);
+    /* polled clients do not register again */
+    CHECK(sim.registered == 2);
+}
+
+static void test_leader_timeout(void)
+{
+    sim_t sim;
+    elect_core_t core;
+    ipv6_addr_t higher;
+    _make_addr(&higher, 3);
+    _start(&sim, &core, 2);
+    _sim_run(&sim, &core, TEST_CONVERGE_MS, &higher);
+    CHECK(core.state == ELECT_STATE_CLIENT);
+    /* heartbeats keep the client, for longer than a timeout */
+    for (unsigned i = 0; i < 2 * (ELECT_LEADER_TIMEOUT / ELECT_MSG_INTERVAL); i++) {
+        elect_core_heartbeat(&core, &higher, (uint16_t)(i + 1));
+        _sim_run(&sim, &core, ELECT_MSG_INTERVAL, NULL);
+    }
+    CHECK(core.state == ELECT_STATE_CLIENT);
+    /* silence for two timeouts loses the leader */
+    _sim_run(&sim, &core, 2 * ELECT_LEADER_TIMEOUT + 1, NULL);
+    CHECK(core.state == ELECT_STATE_DISCOVERY);
+}
+
+static void test_preemption(void)
+{
+    sim_t sim;
+    elect_core_t core;
+    ipv6_addr_t lower;
+    ipv6_addr_t higher;
+    _make_addr(&lower, 1);
+    _make_addr(&higher, 3);
+    _start(&sim, &core, 2);
+    _sim_run(&sim, &core, TEST_CONVERGE_MS, NULL);
+    CHECK(core.state == ELECT_STATE_COORDINATOR);
+    /* a lower node does not take over */
+    elect_core_id(&core, &lower);
+    CHECK(core.state == ELECT_STATE_COORDINATOR);
+    elect_core_id(&core, &higher);
+#if ELECT_HANDOVER
+    CHECK(core.state == ELECT_STATE_CLIENT);
+    CHECK(sim.handovers == 1);
+    CHECK(memcmp(&core.highest, &higher, sizeof(higher)) == 0);
+#else
+    CHECK(core.state == ELECT_STATE_DISCOVERY);
+    _sim_run(&sim, &core, TEST_CONVERGE_MS, &higher);
+    CHECK(core.state == ELECT_STATE_CLIENT);
+#endif
+    CHECK(memcmp(&sim.leader, &higher, sizeof(higher)) == 0);
+}
+
+static void test_ewma(void)
+{
+    ewma_t ewma;
+    ewma_init(&ewma, ELECT_WEIGHT_SHIFT);
+    CHECK(!ewma.valid);
+    CHECK(ewma_update(&ewma, -1234) == -1234);
+
+    /* against a floating point reference, rounded to nearest */
+    double exact = -1234.0;
+    int err = 0;
+    for (unsigned i = 0; i < 10000; i++) {
+        int16_t value = (int16_t)(((i * 2654435761U) >> 20) % 4000) - 2000;
+        exact += (value - exact) / ELECT_WEIGHT;
+        int16_t avg = ewma_update(&ewma, value);
+        long ref = (exact >= 0) ? (long)(exact + 0.5) : -(long)(-exact + 0.5);
+        int d = abs(avg - (int)ref);
+        err = (d > err) ? d : err;
+    }
+    CHECK(err <= 1);
+
+    /* rescaling keeps the average */
+    int16_t before = ewma_get(&ewma);
+    ewma_rescale(&ewma, ELECT_WEIGHT_SHIFT + 2);
+    CHECK(ewma.shift == ELECT_WEIGHT_SHIFT + 2);
+    CHECK(ewma_get(&ewma) == before);
+    ewma_rescale(&ewma, 1);
+    CHECK(abs(ewma_get(&ewma) - before) <= 1);
+    ewma_rescale(&ewma, ELECT_WEIGHT_SHIFT);
+    CHECK(abs(ewma_get(&ewma) - before) <= 1);
+
+    /* a reset keeps the weight */
+    ewma_reset(&ewma);
+    CHECK(!ewma.valid && (ewma.shift == ELECT_WEIGHT_SHIFT));
+    CHECK(ewma_update(&ewma, 42) == 42);
+}
+
+static void _aggr_values(aggr_t *aggr, const int16_t *values, unsigned numof)
+{
+    aggr_reset(aggr);
+    for (unsigned i = 0; i < numof; i++) {
+        aggr_add(aggr, values[i]);
+    }
+}
+
+static void test_aggr(void)
+{
+    aggr_t aggr;
+    elect_summary_t summary;
+
+    static const int16_t odd[] = { 30, -10, 50, 20, 10 };
+    _aggr_values(&aggr, odd, 5);
+    aggr_summary(&aggr, &summary);
+    CHECK(summary.count == 5);
+    CHECK(summary.median == 20);
+    CHECK(summary.mean == 20);
+    CHECK((summary.min == -10) && (summary.max == 50));
+
+    static const int16_t even[] = { 40, 10, 30, 20 };
+    _aggr_values(&aggr, even, 4);
+    aggr_summary(&aggr, &summary);
+    CHECK(summary.count == 4);
+    CHECK(summary.median == 25);
+    CHECK((summary.min == 10) && (summary.max == 40));
+
+    static const int16_t dup[] = { 7, 7, 1, 7 };
+    _aggr_values(&aggr, dup, 4);
+    aggr_summary(&aggr, &summary);
+    CHECK(summary.median == 7);
+
+    aggr_reset(&aggr);
+    aggr_summary(&aggr, &summary);
+    CHECK((summary.count == 0) && (summary.median == 0));
+
+    /* merge: exact mean, min and max, count weighted median */
+    elect_summary_t parts[3];
+    memset(parts, 0, sizeof(parts));
+    parts[0] = (elect_summary_t){ .count = 6, .mean = 30, .median = 30,
+                                  .min = 20, .max = 40 };
+    parts[1] = (elect_summary_t){ .count = 2, .mean = 10, .median = 10,
+                                  .min = 5, .max = 15 };
+    parts[2] = (elect_summary_t){ .count = 0, .mean = 99, .median = 99,
+                                  .min = -99, .max = 99 };
+    for (unsigned i = 0; i < 3; i++) {
+        for (unsigned ch = 0; ch < (ELECT_CHANNEL_NUMOF - 1); ch++) {
+            parts[i].extra[ch] = ELECT_VALUE_NONE;
+        }
+    }
+    aggr_merge(parts, 3, &summary);
+    CHECK(summary.count == 8);
+    CHECK(summary.mean == 25);
+    CHECK(summary.median == 30);
+    CHECK((summary.min == 5) && (summary.max == 40));
+    CHECK(summary.extra[0] == ELECT_VALUE_NONE);
+}
+
+int main(void)
+{
+    test_discovery_coordinator();
+    test_sent_suppressed();
+    test_discovery_client();
+    test_register_retry();
+    test_register_lost();
+    test_leader_timeout();
+    test_preemption();
+    test_ewma();
+    test_aggr();
+    printf("%u checks, %u failed\n", _checked, _failed);
+    return (_failed == 0) ? EXIT_SUCCESS : EXIT_FAILURE;
+}
@@ -0,0 +1,42 @@
+/*
+ * Copyright (c) 2017 HAW Hamburg
+ *
+ * This file is subject to the terms and conditions of the GNU Lesser
+ * General Public License v2.1. See the file LICENSE in the top level
+ * directory for more details.
+ */
+
+/**
+ * @ingroup     vslab-riot
+ * @{
+ *
+ * @file
+ * @brief       Host replacement of the RIOT definitions used by elect.h
+ *
+ * Only constants and types are provided, time is injected into the
+ * election core by the caller.
+ *
+ * @author      Sebastian Meiling <s@mlng.net>
+ */
+
+#ifndef XTIMER_H
+#define XTIMER_H
+
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define MS_PER_SEC      (1000U)
+#define US_PER_MS       (1000U)
+#define US_PER_SEC      (1000000U)
+
+typedef int16_t kernel_pid_t;
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* XTIMER_H */
+/** @} */
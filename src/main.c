@@ -18,7 +18,9 @@
  * @}
  */
 
+#include <inttypes.h>
 #include <stdio.h>
+#include <stdlib.h>
 #include <string.h>
 #include <stdbool.h>
 
@@ -32,31 +34,48 @@
 #include "evtimer_msg.h"
 #include "xtimer.h"
 
+#include "cluster.h"
+#include "config.h"
 #include "elect.h"
+#include "elect_core.h"
+#include "evq.h"
+#include "history.h"
+#include "metrics.h"
+#include "poll.h"
+#include "registry.h"
+#include "rxpool.h"
+#include "sensor.h"
+#include "trace.h"
 
-#define STATE_DISCOVERY 0
-#define STATE_COORDINATOR 1
-#define STATE_CLIENT 2
+/**
+ * @brief Size of the main message queue for timer events, must be a power
+ *        of two
+ */
+#define MAIN_QUEUE_SIZE (16U)
 
-void rescheduleInterval(void);
+void rescheduleInterval(uint32_t offset);
 
-void rescheduleThreshold(void);
+void rescheduleThreshold(uint32_t offset);
 
-void rescheduleTimeout(void);
+void rescheduleTimeout(uint32_t offset);
 
-bool is_addr_bigger(char *str1, char *str2);
+void rescheduleDeadline(uint32_t offset);
 
-int16_t calculateMovingAverage(int16_t oldAverage, int16_t currentValue);
+void rescheduleReply(uint32_t offset);
 
-void addClient(ipv6_addr_t *clientsList, ipv6_addr_t clientIP, int *clientsListCount);
+void sampleSensor(void);
 
-void clearClients(ipv6_addr_t *clientsList, int *clientsListCount);
+void addClient(const ipv6_addr_t *clientIP);
 
-bool addrInList(ipv6_addr_t *clientsList, ipv6_addr_t clientIP, int *clientsListCount);
+void publishNodes(void);
 
-static msg_t _main_msg_queue[ELECT_NODES_NUM];
+static msg_t _main_msg_queue[MAIN_QUEUE_SIZE];
 static kernel_pid_t this_main_pid;
 
+static elect_core_t core;
+/* sensor reading last pushed to the leader and observers */
+static elect_reading_t lastPushed;
+
 /**
  * @name event time configuration
  * @{
@@ -69,8 +88,223 @@ static evtimer_msg_event_t leader_timeout_event = {
     .event = {.offset = ELECT_LEADER_TIMEOUT},
     .msg = {.type = ELECT_LEADER_TIMEOUT_EVENT}};
 static evtimer_msg_event_t leader_threshold_event = {
-    .event = {.offset = ELECT_LEADER_THRESHOLD},
+    .event = {.offset = ELECT_THRESHOLD},
     .msg = {.type = ELECT_LEADER_THRESHOLD_EVENT}};
+static evtimer_msg_event_t poll_deadline_event = {
+    .event = {.offset = ELECT_POLL_DEADLINE},
+    .msg = {.type = ELECT_POLL_DEADLINE_EVENT}};
+static evtimer_msg_event_t reply_event = {
+    .event = {.offset = ELECT_BULLY_BACKOFF},
+    .msg = {.type = ELECT_REPLY_EVENT}};
+/** @} */
+
+/**
+ * @name operations of the election state machine
+ * @{
+ */
+static uint32_t _now(void *ctx)
+{
+    (void)ctx;
+    return xtimer_now_usec();
+}
+
+static uint32_t _random(void *ctx, uint32_t max)
+{
+    (void)ctx;
+    return (max > 0) ? random_uint32_range(0, max) : 0;
+}
+
+static evtimer_msg_event_t *_timer_event(elect_timer_t timer)
+{
+    switch (timer)
+    {
+    case ELECT_TIMER_INTERVAL:
+        return &interval_event;
+    case ELECT_TIMER_THRESHOLD:
+        return &leader_threshold_event;
+    case ELECT_TIMER_TIMEOUT:
+        return &leader_timeout_event;
+    case ELECT_TIMER_DEADLINE:
+        return &poll_deadline_event;
+    case ELECT_TIMER_REPLY:
+        return &reply_event;
+    default:
+        return NULL;
+    }
+}
+
+static void _timer_set(void *ctx, elect_timer_t timer, uint32_t offset)
+{
+    (void)ctx;
+    switch (timer)
+    {
+    case ELECT_TIMER_INTERVAL:
+        rescheduleInterval(offset);
+        break;
+    case ELECT_TIMER_THRESHOLD:
+        rescheduleThreshold(offset);
+        break;
+    case ELECT_TIMER_TIMEOUT:
+        rescheduleTimeout(offset);
+        break;
+    case ELECT_TIMER_DEADLINE:
+        rescheduleDeadline(offset);
+        break;
+    case ELECT_TIMER_REPLY:
+        rescheduleReply(offset);
+        break;
+    default:
+        break;
+    }
+}
+
+static void _timer_del(void *ctx, elect_timer_t timer)
+{
+    (void)ctx;
+    evtimer_msg_event_t *event = _timer_event(timer);
+    if (event != NULL)
+    {
+        evtimer_del(&evtimer, &event->event);
+    }
+}
+
+static int _send_id(void *ctx, const ipv6_addr_t *addr)
+{
+    (void)ctx;
+    return broadcast_id(addr);
+}
+
+static int _send_alive(void *ctx, const ipv6_addr_t *addr)
+{
+    (void)ctx;
+    return broadcast_alive(addr);
+}
+
+static int _send_summary(void *ctx, const elect_summary_t *summary)
+{
+    (void)ctx;
+    for (unsigned ch = 1; ch < ELECT_CHANNEL_NUMOF; ch++)
+    {
+        const sensor_channel_t *channel = sensor_channel(ch);
+        if (summary->extra[ch - 1] != ELECT_VALUE_NONE)
+        {
+            printf("Mittelwert %s: %" PRIi16 " (%s x%u)\n", channel->name,
+                   summary->extra[ch - 1], channel->unit, channel->scale);
+        }
+    }
+#if ELECT_HISTORY
+    /* own multicast is not looped back */
+    history_add(summary);
+#endif
+#if ELECT_CLUSTER
+    cluster_publish(summary);
+    coap_summary_publish(summary);
+#endif
+    return broadcast_summary(summary);
+}
+
+static int _register_at(void *ctx, const ipv6_addr_t *leader,
+                        const ipv6_addr_t *node)
+{
+    (void)ctx;
+    return coap_put_node(*leader, *node);
+}
+
+static int _fetch_nodes(void *ctx, const ipv6_addr_t *node)
+{
+    (void)ctx;
+    return coap_get_nodes(*node);
+}
+
+static int _handover(void *ctx, const ipv6_addr_t *leader,
+                     const ewma_t *average)
+{
+    (void)ctx;
+    /* the average is sent scaled by the compile time weight */
+    ewma_t scaled = *average;
+    ewma_rescale(&scaled, ELECT_WEIGHT_SHIFT);
+    elect_handover_t state = {
+        .from = core.addr,
+        .average = scaled.sum,
+        .epoch = registry_epoch(),
+        .valid = scaled.valid,
+    };
+    // state first, so the new leader is coordinator when the clients arrive
+    if (coap_put_handover(*leader, &state) != 0)
+    {
+        return 1;
+    }
+    ipv6_addr_t nodes[ELECT_NODES_NUM];
+    unsigned numof = registry_addrs(nodes, ELECT_NODES_NUM);
+    if (numof == 0)
+    {
+        return 0;
+    }
+    return coap_put_nodes(*leader, nodes, numof, state.epoch);
+}
+
+static void _sensor_read(void *ctx, elect_reading_t *reading)
+{
+    (void)ctx;
+    sensor_read(reading);
+}
+
+static void _client_add(void *ctx, const ipv6_addr_t *addr)
+{
+    (void)ctx;
+    addClient(addr);
+}
+
+static void _clients_clear(void *ctx)
+{
+    (void)ctx;
+    registry_clear();
+}
+
+static void _round_start(void *ctx)
+{
+    (void)ctx;
+    unsigned evicted = registry_evict(registry_max_age());
+    if (evicted > 0)
+    {
+        printf("%u inaktive Clients entfernt\n", evicted);
+        publishNodes();
+    }
+    poll_start(elect_core_deadline(&core));
+}
+
+static unsigned _round_finish(void *ctx, elect_reading_t *readings,
+                              unsigned max)
+{
+    (void)ctx;
+    poll_report_t report;
+    poll_finish(&report);
+    if (report.numof > 0)
+    {
+        printf("Sensordaten: %u von %u Clients, %u aus Cache, %u verpasst, "
+               "%u ausgesetzt\n", report.answered, report.numof, report.cached,
+               report.missed, report.demoted);
+    }
+    return poll_values(readings, max);
+}
+
+static const elect_core_ops_t _core_ops = {
+    .now = _now,
+    .random = _random,
+    .timer_set = _timer_set,
+    .timer_del = _timer_del,
+    .send_id = _send_id,
+    .send_alive = _send_alive,
+    .send_summary = _send_summary,
+    .register_at = _register_at,
+    .sensor_read = _sensor_read,
+    .fetch_nodes = _fetch_nodes,
+    .handover = _handover,
+    .client_add = _client_add,
+    .clients_clear = _clients_clear,
+    .round_start = _round_start,
+    .round_finish = _round_finish,
+};
 /** @} */
 
 /**
@@ -81,14 +315,12 @@ static evtimer_msg_event_t leader_threshold_event = {
 int setup(void)
 {
     LOG_DEBUG("%s: begin\n", __func__);
-    /* avoid unused variable error */
-    (void)interval_event;
-    (void)leader_timeout_event;
-    (void)leader_threshold_event;
 
-    msg_init_queue(_main_msg_queue, ELECT_NODES_NUM);
+    msg_init_queue(_main_msg_queue, MAIN_QUEUE_SIZE);
     kernel_pid_t main_pid = thread_getpid();
     this_main_pid = main_pid;
+    evq_init(main_pid);
+    poll_init(main_pid);
 
     if (net_init(main_pid) != 0)
     {
@@ -110,27 +342,20 @@ int setup(void)
         LOG_ERROR("init listen!\n");
         return 5;
     }
+#if ELECT_CLUSTER
+    if (cluster_init(main_pid) != 0)
+    {
+        LOG_ERROR("init cluster!\n");
+        return 6;
+    }
+#endif
     LOG_DEBUG("%s: done\n", __func__);
     evtimer_init_msg(&evtimer);
-    /* send initial `TICK` to start eventloop */
-    msg_send(&interval_event.msg, main_pid);
-    /* send initial `TICK` to start eventloop */
-    msg_send(&leader_threshold_event.msg, main_pid);
     return 0;
 }
 
 int main(void)
 {
-    bool otherIPIsHigher = false;
-    bool firstRound = true;
-    bool leaderAlive = true;
-    int msgCounter = 0;
-    int state = 0;
-    ipv6_addr_t highestAddr = {{0}};
-    ipv6_addr_t clientsList[8] = {{{0}}};
-    int clientsListCount = 0;
-    int16_t average = 0;
-
     /* this should be first */
     if (setup() != 0)
     {
@@ -147,347 +372,360 @@ int main(void)
     }
     printf("My addr: %s\n", thisAddrStr); //This works, but the print on the device is lost. It still works!!!!
 
+    elect_core_init(&core, &thisAddr, &_core_ops, NULL);
+    config_params(&core.params);
+    /* schedules initial `TICK` to start eventloop */
+    elect_core_start(&core);
+    sensor_read(&lastPushed);
+
     while (true)
     {
-        msg_t m;
-        msg_receive(&m);
-        switch (m.type)
+        elect_event_t ev;
+        /* timer messages take precedence over queued network events */
+        if ((msg_avail() > 0) || !evq_pop(&ev))
         {
-        case ELECT_INTERVAL_EVENT:
-            LOG_DEBUG("+ ELECT_INTERVAL_EVENT.\n");
-            if (state == STATE_DISCOVERY)
+            msg_t m;
+            msg_receive(&m);
+            if (m.type == ELECT_QUEUE_EVENT)
             {
-                puts("Current State: STATE_DISCOVERY");
-                if (!otherIPIsHigher)
-                {
-                    puts("Broadcaste eigene IP, da keine höherwertigere IP gefunden");
-                    if (broadcast_id(&thisAddr) < 0)
-                    {
-                        printf("%s: failed\n", __func__);
-                    }
-                }
-                rescheduleInterval();
-                clearClients(clientsList, &clientsListCount);
-            }
-            else if (state == STATE_COORDINATOR)
-            {
-                puts("Current State: STATE_COORDINATOR");
-                printf("Broadcaste den Mittelwert: %i\n", average);
-                if (broadcast_sensor(average) < 0)
-                {
-                    printf("%s: failed\n", __func__);
-                }
-                average = sensor_read();
-                puts("Sammle Sensordaten");
-                for (int i = 0; i < clientsListCount; i++)
-                {
-                    coap_get_sensor(clientsList[i]);
-                }
-                rescheduleInterval();
+                continue;
             }
+            ev.type = m.type;
+            ev.kind = ELECT_EVQ_KIND_NONE;
+            ev.data.slot = NULL;
+        }
+        rxpool_slot_t *slot = ev.data.slot;
+        uint32_t start = xtimer_now_usec();
+        uint8_t state = core.state;
+        metrics_event(ev.type);
+        if (ev.kind == ELECT_EVQ_KIND_SLOT)
+        {
+            metrics_time(ELECT_METRICS_HIST_QUEUE, start - slot->time);
+        }
+        TRACE(ev.type, state,
+              (ev.kind == ELECT_EVQ_KIND_SLOT) ? (ipv6_addr_t *)slot->remote.addr.ipv6 : NULL,
+              (ev.kind == ELECT_EVQ_KIND_VALUE) ? (int16_t)ev.data.value : 0);
+        switch (ev.type)
+        {
+        case ELECT_INTERVAL_EVENT:
+            LOG_DEBUG("+ ELECT_INTERVAL_EVENT.\n");
+            elect_core_timer(&core, ELECT_TIMER_INTERVAL);
+            break;
+
+        case ELECT_LEADER_THRESHOLD_EVENT:
+            LOG_DEBUG("+ ELECT_LEADER_THRESHOLD_EVENT.\n");
+            elect_core_timer(&core, ELECT_TIMER_THRESHOLD);
+            break;
 
-            msgCounter = 0;
+        case ELECT_LEADER_TIMEOUT_EVENT:
+            LOG_DEBUG("+ ELECT_LEADER_TIMEOUT_EVENT.\n");
+            elect_core_timer(&core, ELECT_TIMER_TIMEOUT);
+            break;
 
-            puts("_________________________________________________________");
+        case ELECT_POLL_DEADLINE_EVENT:
+            LOG_DEBUG("+ ELECT_POLL_DEADLINE_EVENT.\n");
+            elect_core_timer(&core, ELECT_TIMER_DEADLINE);
+            break;
 
+        case ELECT_REPLY_EVENT:
+            LOG_DEBUG("+ ELECT_REPLY_EVENT.\n");
+            elect_core_timer(&core, ELECT_TIMER_REPLY);
+            break;
+
+        case ELECT_SENSOR_SAMPLE_EVENT:
+            LOG_DEBUG("+ ELECT_SENSOR_SAMPLE_EVENT.\n");
+            sampleSensor();
             break;
 
         case ELECT_BROADCAST_EVENT:
-            LOG_DEBUG("+ ELECT_BROADCAST_EVENT, from [%s]\n", (char *)m.content.ptr);
-            if (is_addr_bigger(thisAddrStr, (char *)m.content.ptr))
+            LOG_DEBUG("+ ELECT_BROADCAST_EVENT.\n");
+            elect_frame_t frame;
+            if (elect_frame_decode(&frame, slot->data, slot->len) != 0)
             {
-                if (state == STATE_DISCOVERY)
-                {
-                    puts("Current State: STATE_DISCOVERY");
-                    puts("höherwertigere IP gefunden.");
-                    otherIPIsHigher = true;
-                }
-                else if (state == STATE_COORDINATOR)
-                {
-                    puts("Current State: STATE_COORDINATOR");
-                    printf("Höherwertigere IP: %s gefunden\n", (char *)m.content.ptr);
-                    puts("Führe Reset aus");
-                    puts("<><><><><><>Bleibe in STATE_DISCOVERY<><><><><><>");
-                    /* send initial `TICK` to start eventloop */
-                    msg_send(&interval_event.msg, this_main_pid);
-                    /* send initial `TICK` to start eventloop */
-                    msg_send(&leader_threshold_event.msg, this_main_pid);
-                    clearClients(clientsList, &clientsListCount);
-                    otherIPIsHigher = false;
-                    firstRound = true;
-                    leaderAlive = true;
-                    msgCounter = 0;
-                    state = STATE_DISCOVERY;
-                    memset(&highestAddr, 0, sizeof(ipv6_addr_t));
-                    average = 0;
-                }
-                else if (state == STATE_CLIENT)
-                {
-                    puts("Current State: STATE_CLIENT");
-                    puts("Coordinator wechsel");
-                    puts("Führe Reset aus");
-                    puts("<><><><><><>Bleibe in STATE_DISCOVERY<><><><><><>");
-                    /* send initial `TICK` to start eventloop */
-                    msg_send(&interval_event.msg, this_main_pid);
-                    /* send initial `TICK` to start eventloop */
-                    msg_send(&leader_threshold_event.msg, this_main_pid);
-                    clearClients(clientsList, &clientsListCount);
-                    otherIPIsHigher = false;
-                    firstRound = true;
-                    leaderAlive = true;
-                    msgCounter = 0;
-                    state = STATE_DISCOVERY;
-                    memset(&highestAddr, 0, sizeof(ipv6_addr_t));
-                    average = 0;
-                }
+                LOG_WARNING("invalid election frame\n");
+                break;
             }
-            else
+            if (frame.type == ELECT_FRAME_TYPE_ALIVE)
             {
-                //Broadcast my IP once, so the other node hears me
-                if (broadcast_id(&thisAddr) < 0)
-                {
-                    printf("%s: failed\n", __func__);
-                }
+                elect_core_heartbeat(&core, &frame.addr, frame.seq);
             }
-            char highestAddrStr[40];
-            ipv6_addr_to_str(highestAddrStr, &highestAddr, 40);
-            if (is_addr_bigger(highestAddrStr, (char *)m.content.ptr))
+            else if (frame.type == ELECT_FRAME_TYPE_ID)
             {
-                ipv6_addr_from_str(&highestAddr, (char *)m.content.ptr);
-                printf("neue höchste Addr %s\n", (char *)m.content.ptr);
+                elect_core_id(&core, &frame.addr);
             }
-            msgCounter++;
-
-            puts("_________________________________________________________");
-
             break;
 
         case ELECT_LEADER_ALIVE_EVENT:
             LOG_DEBUG("+ ELECT_LEADER_ALIVE_EVENT.\n");
-            puts("Nachricht vom Coordinator erhalten");
-            leaderAlive = true;
-
-            puts("_________________________________________________________");
-
+            elect_core_acked(&core);
             break;
 
-        case ELECT_LEADER_TIMEOUT_EVENT:
-            LOG_DEBUG("+ ELECT_LEADER_TIMEOUT_EVENT.\n");
-            if (leaderAlive)
+        case ELECT_NODES_EVENT:
+            LOG_DEBUG("+ ELECT_NODES_EVENT.\n");
+            if (ev.kind != ELECT_EVQ_KIND_SLOT)
             {
-                puts("COORDINATOR ist aktiv");
-                leaderAlive = false;
-                rescheduleTimeout();
+                // a batch is applied as a whole, see coap_nodes_take
+                ipv6_addr_t nodes[ELECT_NODES_NUM];
+                unsigned numof = coap_nodes_take(ELECT_NODES_EVENT, nodes, ELECT_NODES_NUM);
+                for (unsigned i = 0; i < numof; i++)
+                {
+                    elect_core_node(&core, &nodes[i]);
+                }
+                break;
             }
-            else
+            ipv6_addr_t clientIP;
+            if (slot->len != sizeof(clientIP))
             {
-                puts("COORDINATOR ist nicht aktiv");
-                puts("Führe Reset aus");
-                puts("<><><><><><>Bleibe in STATE_DISCOVERY<><><><><><>");
-                /* send initial `TICK` to start eventloop */
-                msg_send(&interval_event.msg, this_main_pid);
-                /* send initial `TICK` to start eventloop */
-                msg_send(&leader_threshold_event.msg, this_main_pid);
-                clearClients(clientsList, &clientsListCount);
-                otherIPIsHigher = false;
-                firstRound = true;
-                leaderAlive = true;
-                msgCounter = 0;
-                state = STATE_DISCOVERY;
-                memset(&highestAddr, 0, sizeof(ipv6_addr_t));
-                average = 0;
+                LOG_WARNING("invalid client address\n");
+                break;
             }
-
-            puts("_________________________________________________________");
-
+            memcpy(&clientIP, slot->data, sizeof(clientIP));
+            elect_core_node(&core, &clientIP);
             break;
 
-        case ELECT_NODES_EVENT:
-            LOG_DEBUG("+ ELECT_NODES_EVENT, from [%s].\n", (char *)m.content.ptr);
-            puts("Clientanmeldung erhalten\n");
-            ipv6_addr_t clientIP;
-            ipv6_addr_from_str(&clientIP, (char *)m.content.ptr);
-            addClient(clientsList, clientIP, &clientsListCount);
-            printf("Anzahl der Clients in der Liste: %i\n", clientsListCount);
+        case ELECT_REGISTER_FAILED_EVENT:
+            LOG_DEBUG("+ ELECT_REGISTER_FAILED_EVENT.\n");
+            elect_core_register_failed(&core);
+            break;
 
-            puts("_________________________________________________________");
+        case ELECT_NODES_BLOCK_EVENT:
+            LOG_DEBUG("+ ELECT_NODES_BLOCK_EVENT, block %u\n", (unsigned)ev.data.value);
+            coap_get_nodes_next((uint32_t)ev.data.value);
+            break;
 
+        case ELECT_HANDOVER_EVENT:
+            LOG_DEBUG("+ ELECT_HANDOVER_EVENT.\n");
+            elect_handover_t handover;
+            if (slot->len != sizeof(handover))
+            {
+                LOG_WARNING("invalid handover\n");
+                break;
+            }
+            memcpy(&handover, slot->data, sizeof(handover));
+            ewma_t average = { .sum = handover.average, .shift = ELECT_WEIGHT_SHIFT,
+                               .valid = handover.valid };
+            elect_core_handover(&core, &handover.from, &average);
             break;
 
         case ELECT_SENSOR_EVENT:
-            LOG_DEBUG("+ ELECT_SENSOR_EVENT, value=%s\n", (char *)m.content.ptr);
-            int16_t value = (int16_t)strtol((char *)m.content.ptr, NULL, 10);
-            average = calculateMovingAverage(average, value);
-
-            puts("_________________________________________________________");
-
+            LOG_DEBUG("+ ELECT_SENSOR_EVENT, reading=%s\n", (char *)slot->data);
+            elect_reading_t reading;
+            if (elect_reading_parse(&reading, (char *)slot->data, slot->len) != 0)
+            {
+                LOG_WARNING("invalid sensor reading\n");
+                break;
+            }
+            ipv6_addr_t sensorAddr;
+            memcpy(&sensorAddr, slot->remote.addr.ipv6, sizeof(sensorAddr));
+            if (!poll_response(&sensorAddr, &reading))
+            {
+                LOG_DEBUG("late or unexpected sensor response\n");
+            }
             break;
 
-        case ELECT_LEADER_THRESHOLD_EVENT:
-            LOG_DEBUG("+ ELECT_LEADER_THRESHOLD_EVENT.\n");
-            if (firstRound)
+        case ELECT_SENSOR_PUSH_EVENT:
+            LOG_DEBUG("+ ELECT_SENSOR_PUSH_EVENT, reading=%s\n", (char *)slot->data);
+            elect_reading_t pushed;
+            if (elect_reading_parse(&pushed, (char *)slot->data, slot->len) != 0)
             {
-                rescheduleThreshold();
-                firstRound = false;
-
-                puts("_________________________________________________________");
-
+                LOG_WARNING("invalid sensor reading\n");
                 break;
             }
-            printf("msgCounter ist %i\n", msgCounter);
-            if (otherIPIsHigher && msgCounter < 2)
+            ipv6_addr_t pushAddr;
+            memcpy(&pushAddr, slot->remote.addr.ipv6, sizeof(pushAddr));
+            if (!poll_push(&pushAddr, &pushed) && (core.state == ELECT_STATE_COORDINATOR))
             {
-                puts("<><><><><><>Wechsle in STATE_CLIENT<><><><><><>");
-                state = STATE_CLIENT;
-
-                char highestAddrStr[40];
-                ipv6_addr_to_str(highestAddrStr, &highestAddr, 40);
-                char thisAddrStr[40];
-                ipv6_addr_to_str(thisAddrStr, &thisAddr, 40);
-
-                if (coap_put_node(highestAddr, thisAddr) == 0)
-                {
-                    printf("Clientanmeldung: %s, an Coordinator: %s", thisAddrStr, highestAddrStr);
-                    printf("Success\n");
-                }
-
-                msg_send(&leader_timeout_event.msg, this_main_pid);
+                // the push is acknowledged, so it stands in for a lost registration
+                LOG_DEBUG("sensor value from unknown client\n");
+                elect_core_node(&core, &pushAddr);
+                poll_push(&pushAddr, &pushed);
+            }
+            break;
 
-                puts("_________________________________________________________");
+        case ELECT_POLL_TIMEOUT_EVENT:
+            LOG_DEBUG("+ ELECT_POLL_TIMEOUT_EVENT, msg ID %u\n", (unsigned)ev.data.value);
+            poll_timeout((uint16_t)ev.data.value);
+            break;
 
+#if ELECT_HISTORY
+        case ELECT_SUMMARY_EVENT:
+            LOG_DEBUG("+ ELECT_SUMMARY_EVENT.\n");
+            elect_summary_t received;
+            if (elect_summary_decode(&received, slot->data, slot->len) != 0)
+            {
+                LOG_WARNING("invalid summary\n");
                 break;
             }
-            else if (!otherIPIsHigher && msgCounter < 2)
-            {
-                puts("<><><><><><>Wechsle in STATE_COORDINATOR<><><><><><>");
-                state = STATE_COORDINATOR;
-                rescheduleInterval();
+            history_add(&received);
+            break;
+#endif
 
-                puts("_________________________________________________________");
+        case ELECT_POLL_RTO_EVENT:
+            LOG_DEBUG("+ ELECT_POLL_RTO_EVENT.\n");
+            poll_expire();
+            break;
 
+        case ELECT_CONFIG_EVENT:
+            LOG_DEBUG("+ ELECT_CONFIG_EVENT.\n");
+            config_t config;
+            if (slot->len != sizeof(config))
+            {
+                LOG_WARNING("invalid configuration\n");
                 break;
             }
-            else
+            memcpy(&config, slot->data, sizeof(config));
+            unsigned changed = config_commit(&config);
+            if (changed & ELECT_CONFIG_TIMING)
             {
-                puts("<><><><><><>Bleibe in STATE_DISCOVERY<><><><><><>");
+                elect_params_t params;
+                config_params(&params);
+                elect_core_configure(&core, &params);
+#if ELECT_CLUSTER
+                cluster_configure(&params);
+#endif
+            }
+            if (changed & (1U << ELECT_CONFIG_TXPOWER))
+            {
+                net_set_txpower((int16_t)config_get(ELECT_CONFIG_TXPOWER));
+            }
+            if (changed)
+            {
+                printf("Konfiguration geaendert (Maske 0x%02x)\n", changed);
             }
-
-            msgCounter = 0;
-
-            rescheduleThreshold();
-
-            puts("_________________________________________________________");
-
             break;
 
         default:
-            LOG_WARNING("??? invalid event (%x) ???\n", m.type);
+#if ELECT_CLUSTER
+            if (cluster_event(&ev))
+            {
+                break;
+            }
+#endif
+            LOG_WARNING("??? invalid event (%x) ???\n", ev.type);
             break;
         }
-        /* !!! DO NOT REMOVE !!! */
-        if ((m.type != ELECT_INTERVAL_EVENT) &&
-            (m.type != ELECT_LEADER_TIMEOUT_EVENT) &&
-            (m.type != ELECT_LEADER_THRESHOLD_EVENT))
+        metrics_time(ELECT_METRICS_HIST_HANDLER, xtimer_now_usec() - start);
+        if (core.state != state)
         {
-            msg_reply(&m, &m);
+            TRACE(ELECT_TRACE_STATE, core.state, &core.highest, state);
         }
+#if ELECT_CLUSTER
+        /* run the root election while coordinator of the own cluster */
+        cluster_update(core.state);
+#endif
+        /* producers hand over their slot reference, drop it when done */
+        evq_done(&ev);
     }
     /* should never be reached */
     return 0;
 }
 
-void rescheduleInterval(void)
+void rescheduleInterval(uint32_t offset)
 {
     // remove existing event
     evtimer_del(&evtimer, &interval_event.event);
     // reset event timer offset
-    interval_event.event.offset = ELECT_MSG_INTERVAL;
+    interval_event.event.offset = offset;
     // (re)schedule event message
     evtimer_add_msg(&evtimer, &interval_event, this_main_pid);
 }
 
-void rescheduleThreshold(void)
+void rescheduleThreshold(uint32_t offset)
 {
     // remove existing event
     evtimer_del(&evtimer, &leader_threshold_event.event);
     // reset event timer offset
-    leader_threshold_event.event.offset = ELECT_LEADER_THRESHOLD;
+    leader_threshold_event.event.offset = offset;
     // (re)schedule event message
     evtimer_add_msg(&evtimer, &leader_threshold_event, this_main_pid);
 }
 
-void rescheduleTimeout(void)
+void rescheduleTimeout(uint32_t offset)
 {
     // remove existing event
     evtimer_del(&evtimer, &leader_timeout_event.event);
     // reset event timer offset
-    leader_timeout_event.event.offset = ELECT_LEADER_TIMEOUT;
+    leader_timeout_event.event.offset = offset;
     // (re)schedule event message
     evtimer_add_msg(&evtimer, &leader_timeout_event, this_main_pid);
 }
 
-bool is_addr_bigger(char *str1, char *str2)
+void rescheduleDeadline(uint32_t offset)
 {
-    ipv6_addr_t addr1;
-    ipv6_addr_t addr2;
-
-    ipv6_addr_from_str(&addr1, str1);
-    ipv6_addr_from_str(&addr2, str2);
-
-    int cmp = ipv6_addr_cmp(&addr1, &addr2);
-
-    if (cmp < 0)
-    {
-        return true;
-    }
-    else
-    {
-        return false;
-    }
+    // remove existing event
+    evtimer_del(&evtimer, &poll_deadline_event.event);
+    // reset event timer offset
+    poll_deadline_event.event.offset = offset;
+    // (re)schedule event message
+    evtimer_add_msg(&evtimer, &poll_deadline_event, this_main_pid);
 }
 
-int16_t calculateMovingAverage(int16_t oldAverage, int16_t currentValue)
+void rescheduleReply(uint32_t offset)
 {
-    int16_t Xi = oldAverage;
-    int16_t x = currentValue;
-
-    int16_t result = (int16_t)((double)((((16.0 - 1.0) / 16.0) * (double)Xi) + ((1.0 / 16.0) * (double)x)));
-
-    return result;
+    // remove existing event
+    evtimer_del(&evtimer, &reply_event.event);
+    // reset event timer offset
+    reply_event.event.offset = offset;
+    // (re)schedule event message
+    evtimer_add_msg(&evtimer, &reply_event, this_main_pid);
 }
 
-void addClient(ipv6_addr_t *clientsList, ipv6_addr_t clientIP, int *clientsListCount)
+void sampleSensor(void)
 {
-    if (!addrInList(clientsList, clientIP, clientsListCount))
+    elect_reading_t reading;
+    sensor_read(&reading);
+    // all channels are pushed together once any of them changed
+    bool changed = false;
+    for (unsigned ch = 0; ch < ELECT_CHANNEL_NUMOF; ch++)
     {
-        clientsList[*clientsListCount] = clientIP;
-        *clientsListCount = *clientsListCount + 1;
-        puts("Client IP in Liste hinzugefügt");
-        if (*clientsListCount < 0)
+        if (abs(reading.values[ch] - lastPushed.values[ch]) >
+            sensor_channel(ch)->threshold)
         {
-            puts("This will never happen");
+            changed = true;
         }
     }
-    else
+    if (!changed)
     {
-        puts("Client bereits in der Liste");
+        return;
+    }
+    lastPushed = reading;
+    coap_notify_sensor(&reading);
+    if (core.state == ELECT_STATE_CLIENT)
+    {
+        if (coap_push_sensor(core.highest, core.addr, &reading) != 0)
+        {
+            LOG_WARNING("failed to push sensor value\n");
+        }
     }
 }
 
-void clearClients(ipv6_addr_t *clientsList, int *clientsListCount)
+void addClient(const ipv6_addr_t *clientIP)
 {
-    memset(clientsList, 0, sizeof(ipv6_addr_t) * 8);
-    *clientsListCount = 0;
+    if (registry_find(clientIP) == NULL)
+    {
+        LOG_DEBUG("Client IP in Liste hinzugefügt\n");
+    }
+    else
+    {
+        LOG_DEBUG("Client bereits in der Liste\n");
+    }
+    registry_add(clientIP);
+    LOG_DEBUG("Anzahl der Clients in der Liste: %u\n", registry_numof());
+    publishNodes();
 }
 
-bool addrInList(ipv6_addr_t *clientsList, ipv6_addr_t clientIP, int *clientsListCount)
+void publishNodes(void)
 {
-    for (int i = 0; i < *clientsListCount; i++)
+    // clients are not published on reset, a new coordinator may fetch them
+    static uint16_t publishedEpoch;
+    static bool published = false;
+    if (published && (registry_epoch() == publishedEpoch))
     {
-        if (ipv6_addr_cmp(clientsList + i, &clientIP) == 0)
-        {
-            return true;
-        }
+        return;
     }
-    return false;
-}
\ No newline at end of file
+    ipv6_addr_t nodes[ELECT_NODES_NUM];
+    unsigned numof = registry_addrs(nodes, ELECT_NODES_NUM);
+    publishedEpoch = registry_epoch();
+    published = true;
+    coap_nodes_publish(nodes, numof, publishedEpoch);
+}
@@ -0,0 +1,102 @@
+/*
+ * Copyright (c) 2017 HAW Hamburg
+ *
+ * This file is subject to the terms and conditions of the GNU Lesser
+ * General Public License v2.1. See the file LICENSE in the top level
+ * directory for more details.
+ */
+
+/**
+ * @ingroup     vslab-riot
+ * @{
+ *
+ * @file
+ * @brief       Runtime counters and latency histograms
+ *
+ * @author      Sebastian Meiling <s@mlng.net>
+ *
+ * @}
+ */
+
+#include "byteorder.h"
+#include "irq.h"
+
+#include "evq.h"
+#include "metrics.h"
+
+#define EVQ_STATS_NUMOF     (4U)
+
+static uint32_t _counters[ELECT_METRICS_COUNTER_NUMOF];
+static uint32_t _events[ELECT_METRICS_EVENT_NUMOF];
+static uint32_t _hists[ELECT_METRICS_HIST_NUMOF][ELECT_METRICS_BUCKETS];
+
+/* increments are no single instruction, writers run in several threads */
+static inline void _inc(uint32_t *value)
+{
+    unsigned irq = irq_disable();
+    (*value)++;
+    irq_restore(irq);
+}
+
+void metrics_inc(metrics_counter_t counter)
+{
+    _inc(&_counters[counter]);
+}
+
+void metrics_event(uint16_t type)
+{
+    unsigned i = (uint16_t)(type - ELECT_METRICS_EVENT_BASE);
+    if (i >= ELECT_METRICS_EVENT_NUMOF) {
+        i = ELECT_METRICS_EVENT_NUMOF - 1;
+    }
+    _inc(&_events[i]);
+}
+
+void metrics_time(metrics_hist_t hist, uint32_t usec)
+{
+    unsigned bucket = 0;
+    usec >>= ELECT_METRICS_BUCKET_SHIFT;
+    while ((usec > 0) && (bucket < (ELECT_METRICS_BUCKETS - 1))) {
+        usec >>= 1;
+        bucket++;
+    }
+    _inc(&_hists[hist][bucket]);
+}
+
+unsigned metrics_encode_hdr(uint8_t *buf)
+{
+    buf[0] = ELECT_METRICS_VERSION;
+    buf[1] = ELECT_METRICS_COUNTER_NUMOF;
+    buf[2] = ELECT_METRICS_EVENT_NUMOF;
+    buf[3] = ELECT_METRICS_HIST_NUMOF;
+    buf[4] = ELECT_METRICS_BUCKETS;
+    buf[5] = ELECT_METRICS_BUCKET_SHIFT;
+    byteorder_htobebufs(&buf[6], ELECT_METRICS_EVENT_BASE);
+    return ELECT_METRICS_COUNTER_NUMOF + ELECT_METRICS_EVENT_NUMOF +
+           EVQ_STATS_NUMOF + (ELECT_METRICS_HIST_NUMOF * ELECT_METRICS_BUCKETS);
+}
+
+uint32_t metrics_get(unsigned i)
+{
+    if (i < ELECT_METRICS_COUNTER_NUMOF) {
+        return _counters[i];
+    }
+    i -= ELECT_METRICS_COUNTER_NUMOF;
+    if (i < ELECT_METRICS_EVENT_NUMOF) {
+        return _events[i];
+    }
+    i -= ELECT_METRICS_EVENT_NUMOF;
+    if (i < EVQ_STATS_NUMOF) {
+        evq_stats_t stats;
+        evq_stats(&stats);
+        uint32_t values[EVQ_STATS_NUMOF] = {
+            stats.pushed, stats.dropped, stats.depth, stats.max_depth
+        };
+        return values[i];
+    }
+    i -= EVQ_STATS_NUMOF;
+    if (i < (ELECT_METRICS_HIST_NUMOF * ELECT_METRICS_BUCKETS)) {
+        return _hists[i / ELECT_METRICS_BUCKETS][i % ELECT_METRICS_BUCKETS];
+    }
+    return 0;
+}
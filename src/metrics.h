@@ -0,0 +1,149 @@
+/*
+ * Copyright (c) 2017 HAW Hamburg
+ *
+ * This file is subject to the terms and conditions of the GNU Lesser
+ * General Public License v2.1. See the file LICENSE in the top level
+ * directory for more details.
+ */
+
+/**
+ * @ingroup     vslab-riot
+ * @{
+ *
+ * @file
+ * @brief       Runtime counters and latency histograms
+ *
+ * Counters and histograms have a fixed size and can be updated from any
+ * thread. Histograms have log2 buckets: bucket 0 counts times below
+ * 2^@ref ELECT_METRICS_BUCKET_SHIFT usec, each following bucket twice the
+ * range of the previous one, the last bucket all longer times.
+ *
+ * All values are served at GET `/metrics`, decode them with
+ * `tools/metrics_decode.py`.
+ *
+ * @author      Sebastian Meiling <s@mlng.net>
+ */
+
+#ifndef METRICS_H
+#define METRICS_H
+
+#include <stdint.h>
+
+#include "elect.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * @brief Number of buckets per histogram
+ */
+#define ELECT_METRICS_BUCKETS       (16U)
+
+/**
+ * @brief Upper bound of the first bucket as power of two in usec, 128 usec
+ */
+#define ELECT_METRICS_BUCKET_SHIFT  (7U)
+
+/**
+ * @brief First event type counted per type, see ELECT_*_EVENT
+ */
+#define ELECT_METRICS_EVENT_BASE    ELECT_BROADCAST_EVENT
+
+/**
+ * @brief Number of event types counted, larger ones share the last counter
+ */
+#define ELECT_METRICS_EVENT_NUMOF   (32U)
+
+/**
+ * @brief Counters
+ */
+typedef enum {
+    ELECT_METRICS_RX = 0,           /**< datagrams received by the listeners */
+    ELECT_METRICS_RX_DROP,          /**< datagrams dropped, no receive slot */
+    ELECT_METRICS_COAP_SERVED,      /**< requests handled by own resources */
+    ELECT_METRICS_COAP_SENT,        /**< own requests sent */
+    ELECT_METRICS_COAP_SEND_FAIL,   /**< own requests not sent, e.g. no memo */
+    ELECT_METRICS_COAP_RESP,        /**< responses to own requests */
+    ELECT_METRICS_COAP_TIMEOUT,     /**< own requests timed out */
+    ELECT_METRICS_POLL_MISSED,      /**< nodes without answer in a round */
+    ELECT_METRICS_POLL_RETRY,       /**< sensor requests sent again after RTO */
+    ELECT_METRICS_POLL_DEMOTED,     /**< nodes not polled in a round */
+    ELECT_METRICS_RX_FILTERED,      /**< repeated election frames dropped */
+    ELECT_METRICS_RX_COALESCED,     /**< IDs merged into a higher one */
+    ELECT_METRICS_TX_SUPPRESSED,    /**< own IDs not sent, see ELECT_BC_TX_HOLDOFF */
+    ELECT_METRICS_COUNTER_NUMOF
+} metrics_counter_t;
+
+/**
+ * @brief Latency histograms
+ */
+typedef enum {
+    ELECT_METRICS_HIST_QUEUE = 0,   /**< arrival to dispatch of received data */
+    ELECT_METRICS_HIST_HANDLER,     /**< handling of an event by main */
+    ELECT_METRICS_HIST_POLL_RTT,    /**< sensor request to response */
+    ELECT_METRICS_HIST_POLL_ROUND,  /**< start to last response of a round */
+    ELECT_METRICS_HIST_NUMOF
+} metrics_hist_t;
+
+/**
+ * @name Encoding served at GET `/metrics`
+ *
+ * Header: version (1), number of counters (1), event types (1),
+ * histograms (1), buckets (1), bucket shift (1), first event type (2).
+ * Then unsigned 32 bit values follow: counters, events per type, the
+ * counters of @ref evq_stats_t (pushed, dropped, depth, max. depth) and the
+ * buckets of all histograms. All numbers are big endian.
+ * @{
+ */
+#define ELECT_METRICS_VERSION       (0x01)
+#define ELECT_METRICS_HDR_LEN       (8U)
+/** @} */
+
+/**
+ * @brief Increment a counter
+ *
+ * @param[in] counter   counter
+ */
+void metrics_inc(metrics_counter_t counter);
+
+/**
+ * @brief Count an event handled by the main thread
+ *
+ * @param[in] type      event type, ELECT_*_EVENT
+ */
+void metrics_event(uint16_t type);
+
+/**
+ * @brief Add a duration to a histogram
+ *
+ * @param[in] hist      histogram
+ * @param[in] usec      duration in usec
+ */
+void metrics_time(metrics_hist_t hist, uint32_t usec);
+
+/**
+ * @brief Encode the header of all values
+ *
+ * @param[out] buf  destination, at least @ref ELECT_METRICS_HDR_LEN bytes
+ *
+ * @returns number of values that follow
+ */
+unsigned metrics_encode_hdr(uint8_t *buf);
+
+/**
+ * @brief Get a value in the order of the encoding
+ *
+ * @param[in] i     index, below the number returned by
+ *                  @ref metrics_encode_hdr
+ *
+ * @returns the value
+ */
+uint32_t metrics_get(unsigned i);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* METRICS_H */
+/** @} */
@@ -0,0 +1,446 @@
+/*
+ * Copyright (c) 2017 HAW Hamburg
+ *
+ * This file is subject to the terms and conditions of the GNU Lesser
+ * General Public License v2.1. See the file LICENSE in the top level
+ * directory for more details.
+ */
+
+/**
+ * @ingroup     vslab-riot
+ * @{
+ *
+ * @file
+ * @brief       Scatter-gather polling of sensor values
+ *
+ * @author      Sebastian Meiling <s@mlng.net>
+ *
+ * @}
+ */
+
+#include <string.h>
+
+#include "log.h"
+#include "msg.h"
+#include "net/gcoap.h"
+#include "xtimer.h"
+
+#include "config.h"
+#include "metrics.h"
+#include "poll.h"
+#include "registry.h"
+
+/**
+ * @name States of a poll target
+ * @{
+ */
+#define TARGET_PENDING  (0)     /**< request not sent yet */
+#define TARGET_INFLIGHT (1)     /**< waiting for response */
+#define TARGET_DONE     (2)     /**< valid response received */
+#define TARGET_FAILED   (3)     /**< request failed or timed out */
+#define TARGET_CACHED   (4)     /**< value still fresh, not requested */
+#define TARGET_DEMOTED  (5)     /**< not polled in this round */
+/** @} */
+
+/**
+ * @brief Max. exponent of the RTO backoff
+ */
+#define POLL_BACKOFF_MAX    (4U)
+
+/**
+ * @brief Time after which gcoap has released the memo of a request in usec
+ *
+ * Requests are sent non-confirmable, the margin covers the delivery of the
+ * timeout event.
+ */
+#define POLL_MEMO_LIFETIME  (GCOAP_NON_TIMEOUT + US_PER_SEC)
+
+typedef struct {
+    ipv6_addr_t addr;
+    uint32_t sent;
+    uint32_t expires;
+    uint16_t msg_id;
+    uint8_t state;
+    uint8_t retries;
+    elect_reading_t reading;
+} poll_target_t;
+
+/* a sensor request whose gcoap memo may still be held */
+typedef struct {
+    ipv6_addr_t addr;
+    uint32_t sent;
+    uint16_t msg_id;
+    bool used;
+} poll_memo_t;
+
+static poll_target_t _targets[ELECT_NODES_NUM];
+static unsigned _numof;
+static unsigned _next;
+static bool _active;
+static uint32_t _start;
+static uint32_t _deadline;
+static uint32_t _last;
+/* memos outlive rounds and retries, the window counts them, not targets */
+static poll_memo_t _memos[ELECT_POLL_WINDOW];
+static unsigned _memos_used;
+
+static kernel_pid_t _main_pid = KERNEL_PID_UNDEF;
+static xtimer_t _rto_timer;
+static msg_t _rto_msg = { .type = ELECT_POLL_RTO_EVENT };
+
+/* upper bound of the request timeout in usec, scaled to the runtime interval */
+static uint32_t _rto_max(void)
+{
+    return (uint32_t)(((uint64_t)ELECT_POLL_RTO_MAX * US_PER_MS *
+                       (uint32_t)config_get(ELECT_CONFIG_INTERVAL)) / ELECT_MSG_INTERVAL);
+}
+
+/* request timeout of a node in usec, see RFC 6298 section 2 */
+static uint32_t _rto(const registry_entry_t *e)
+{
+    uint32_t rto = ELECT_POLL_RTO_INIT * US_PER_MS;
+    if ((e != NULL) && (e->srtt > 0)) {
+        rto = e->srtt + 4 * e->rttvar;
+    }
+    if (e != NULL) {
+        rto <<= e->backoff;
+    }
+    if (rto < (ELECT_POLL_RTO_MIN * US_PER_MS)) {
+        rto = ELECT_POLL_RTO_MIN * US_PER_MS;
+    }
+    if (rto > _rto_max()) {
+        rto = _rto_max();
+    }
+    return rto;
+}
+
+static void _rtt_sample(registry_entry_t *e, uint32_t rtt)
+{
+    if (e->srtt == 0) {
+        e->srtt = (rtt > 0) ? rtt : 1;
+        e->rttvar = rtt / 2;
+    }
+    else {
+        uint32_t delta = (e->srtt > rtt) ? (e->srtt - rtt) : (rtt - e->srtt);
+        e->rttvar = (3 * e->rttvar + delta) / 4;
+        e->srtt = (7 * e->srtt + rtt) / 8;
+    }
+    e->backoff = 0;
+}
+
+static void _memo_release(poll_memo_t *m)
+{
+    m->used = false;
+    _memos_used--;
+}
+
+/* release memos gcoap has dropped without an event reaching us, e.g. a
+ * response lost to a full receive pool */
+static void _memo_expire(uint32_t now)
+{
+    for (unsigned i = 0; i < ELECT_POLL_WINDOW; ++i) {
+        if (_memos[i].used &&
+            ((now - _memos[i].sent) >= POLL_MEMO_LIFETIME)) {
+            _memo_release(&_memos[i]);
+        }
+    }
+}
+
+static poll_memo_t *_memo_alloc(void)
+{
+    _memo_expire(xtimer_now_usec());
+    for (unsigned i = 0; i < ELECT_POLL_WINDOW; ++i) {
+        if (!_memos[i].used) {
+            return &_memos[i];
+        }
+    }
+    return NULL;
+}
+
+/* arm the timer for the earliest request expiry */
+static void _arm(void)
+{
+    xtimer_remove(&_rto_timer);
+    if (!_active || (_main_pid == KERNEL_PID_UNDEF)) {
+        return;
+    }
+    uint32_t now = xtimer_now_usec();
+    uint32_t wait = UINT32_MAX;
+    for (unsigned i = 0; i < _next; ++i) {
+        poll_target_t *t = &_targets[i];
+        if (t->state != TARGET_INFLIGHT) {
+            continue;
+        }
+        int32_t left = (int32_t)(t->expires - now);
+        uint32_t w = (left > 0) ? (uint32_t)left : 0;
+        if (w < wait) {
+            wait = w;
+        }
+    }
+    /* targets wait for a memo that is only released by its lifetime */
+    if ((_next < _numof) && (_memos_used == ELECT_POLL_WINDOW)) {
+        for (unsigned i = 0; i < ELECT_POLL_WINDOW; ++i) {
+            uint32_t w = POLL_MEMO_LIFETIME - (now - _memos[i].sent);
+            if ((int32_t)w < 0) {
+                w = 0;
+            }
+            if (w < wait) {
+                wait = w;
+            }
+        }
+    }
+    if (wait != UINT32_MAX) {
+        xtimer_set_msg(&_rto_timer, wait, &_rto_msg, _main_pid);
+    }
+}
+
+/* needs a free memo, see _memo_alloc */
+static bool _send(poll_target_t *t, poll_memo_t *m)
+{
+    if (coap_get_sensor(t->addr, &t->msg_id) != 0) {
+        return false;
+    }
+    t->sent = xtimer_now_usec();
+    t->expires = t->sent + _rto(registry_find(&t->addr));
+    m->addr = t->addr;
+    m->sent = t->sent;
+    m->msg_id = t->msg_id;
+    m->used = true;
+    _memos_used++;
+    return true;
+}
+
+static void _fill(void)
+{
+    poll_memo_t *m;
+    while (_active && (_next < _numof) && (m = _memo_alloc())) {
+        poll_target_t *t = &_targets[_next++];
+        if ((t->state == TARGET_CACHED) || (t->state == TARGET_DEMOTED)) {
+            continue;
+        }
+        if (_send(t, m)) {
+            t->state = TARGET_INFLIGHT;
+        }
+        else {
+            t->state = TARGET_FAILED;
+        }
+    }
+    _arm();
+}
+
+void poll_init(kernel_pid_t main)
+{
+    _main_pid = main;
+}
+
+void poll_start(uint32_t deadline)
+{
+    if (_active) {
+        poll_report_t report;
+        poll_finish(&report);
+    }
+    /* poll demoted nodes again once half of their time to eviction is up */
+    uint32_t now = xtimer_now_usec();
+    uint32_t demote_age = (registry_max_age() / 2U) * US_PER_MS;
+    unsigned numof = 0;
+    registry_entry_t *e = NULL;
+    while ((numof < ELECT_NODES_NUM) && (e = registry_iter(e))) {
+        poll_target_t *t = &_targets[numof];
+        t->addr = e->addr;
+        t->state = TARGET_PENDING;
+        t->retries = 0;
+        if (registry_fresh(e)) {
+            t->state = TARGET_CACHED;
+            t->reading = e->reading;
+        }
+        else if ((e->skip > 0) && ((now - e->last_seen) < demote_age)) {
+            e->skip--;
+            t->state = TARGET_DEMOTED;
+        }
+        else {
+            e->skip = 0;
+        }
+        numof++;
+    }
+    _numof = numof;
+    _next = 0;
+    _active = true;
+    _start = xtimer_now_usec();
+    _deadline = deadline * US_PER_MS;
+    _last = _start;
+    _fill();
+}
+
+bool poll_response(const ipv6_addr_t *addr, const elect_reading_t *reading)
+{
+    /* gcoap released the memo of one request to the node, assume the oldest,
+     * a wrong guess only delays the release until its lifetime ends */
+    poll_memo_t *oldest = NULL;
+    for (unsigned i = 0; i < ELECT_POLL_WINDOW; ++i) {
+        poll_memo_t *m = &_memos[i];
+        if (m->used && (ipv6_addr_cmp(&m->addr, addr) == 0) &&
+            ((oldest == NULL) || ((int32_t)(m->sent - oldest->sent) < 0))) {
+            oldest = m;
+        }
+    }
+    if (oldest != NULL) {
+        _memo_release(oldest);
+    }
+    if (!_active) {
+        return false;
+    }
+    for (unsigned i = 0; i < _next; ++i) {
+        poll_target_t *t = &_targets[i];
+        /* late answers to expired requests are still welcome */
+        if (((t->state == TARGET_INFLIGHT) || (t->state == TARGET_FAILED)) &&
+            (ipv6_addr_cmp(&t->addr, addr) == 0)) {
+            t->state = TARGET_DONE;
+            t->reading = *reading;
+            _last = xtimer_now_usec();
+            /* the node may have been evicted during the round, its answer
+             * still counts but must not register it again */
+            registry_entry_t *e = registry_find(addr);
+            if (e != NULL) {
+                e->answers++;
+                registry_cache(e, reading);
+                /* Karn's algorithm, no samples of retried requests */
+                if (t->retries == 0) {
+                    _rtt_sample(e, _last - t->sent);
+                }
+            }
+            metrics_time(ELECT_METRICS_HIST_POLL_RTT, _last - t->sent);
+            _fill();
+            return true;
+        }
+    }
+    _fill();
+    return false;
+}
+
+bool poll_push(const ipv6_addr_t *addr, const elect_reading_t *reading)
+{
+    registry_entry_t *e = registry_find(addr);
+    if (e == NULL) {
+        return false;
+    }
+    registry_cache(e, reading);
+    return true;
+}
+
+void poll_timeout(uint16_t msg_id)
+{
+    for (unsigned i = 0; i < ELECT_POLL_WINDOW; ++i) {
+        if (_memos[i].used && (_memos[i].msg_id == msg_id)) {
+            _memo_release(&_memos[i]);
+            break;
+        }
+    }
+    if (!_active) {
+        return;
+    }
+    for (unsigned i = 0; i < _next; ++i) {
+        poll_target_t *t = &_targets[i];
+        if ((t->state == TARGET_INFLIGHT) && (t->msg_id == msg_id)) {
+            t->state = TARGET_FAILED;
+            break;
+        }
+    }
+    _fill();
+}
+
+void poll_expire(void)
+{
+    if (!_active) {
+        return;
+    }
+    uint32_t now = xtimer_now_usec();
+    uint32_t end = _start + _deadline;
+    for (unsigned i = 0; i < _next; ++i) {
+        poll_target_t *t = &_targets[i];
+        if ((t->state != TARGET_INFLIGHT) ||
+            ((int32_t)(t->expires - now) > 0)) {
+            continue;
+        }
+        registry_entry_t *e = registry_find(&t->addr);
+        if ((e != NULL) && (e->backoff < POLL_BACKOFF_MAX)) {
+            e->backoff++;
+        }
+        /* retry only if the answer may still arrive within the round, and
+         * a memo is free, the one of the first request is still held */
+        poll_memo_t *m;
+        if ((t->retries < ELECT_POLL_RETRIES) &&
+            ((int32_t)(end - (now + _rto(e))) > 0) &&
+            (m = _memo_alloc()) && _send(t, m)) {
+            t->retries++;
+            metrics_inc(ELECT_METRICS_POLL_RETRY);
+            continue;
+        }
+        /* the memo stays in the window until gcoap releases it */
+        t->state = TARGET_FAILED;
+    }
+    _fill();
+}
+
+void poll_finish(poll_report_t *report)
+{
+    memset(report, 0, sizeof(*report));
+    if (!_active) {
+        return;
+    }
+    _active = false;
+    xtimer_remove(&_rto_timer);
+    report->numof = _numof;
+    report->duration = _last - _start;
+    metrics_time(ELECT_METRICS_HIST_POLL_ROUND, report->duration);
+    for (unsigned i = 0; i < _numof; ++i) {
+        registry_entry_t *e = registry_find(&_targets[i].addr);
+        if (_targets[i].state == TARGET_DONE) {
+            report->answered++;
+            if (e != NULL) {
+                e->fails = 0;
+            }
+        }
+        else if (_targets[i].state == TARGET_CACHED) {
+            report->cached++;
+        }
+        else if (_targets[i].state == TARGET_DEMOTED) {
+            report->demoted++;
+            metrics_inc(ELECT_METRICS_POLL_DEMOTED);
+        }
+        else {
+            char addr_str[IPV6_ADDR_MAX_STR_LEN];
+            ipv6_addr_to_str(addr_str, &_targets[i].addr, sizeof(addr_str));
+            LOG_INFO("%s: no answer from %s\n", __func__, addr_str);
+            report->missed++;
+            metrics_inc(ELECT_METRICS_POLL_MISSED);
+            if (e == NULL) {
+                continue;
+            }
+            e->misses++;
+            if (e->fails < UINT8_MAX) {
+                e->fails++;
+            }
+            if (e->fails >= ELECT_POLL_DEMOTE) {
+                /* skip 1, 2, 4, ... rounds while the node keeps missing */
+                unsigned shift = e->fails - ELECT_POLL_DEMOTE;
+                unsigned skip = (shift < 8) ? (1U << shift) : UINT8_MAX;
+                e->skip = (skip < ELECT_POLL_DEMOTE_MAX) ? skip
+                                                         : ELECT_POLL_DEMOTE_MAX;
+                LOG_INFO("%s: %s demoted for %u rounds\n", __func__,
+                         addr_str, (unsigned)e->skip);
+            }
+        }
+    }
+}
+
+unsigned poll_values(elect_reading_t *readings, unsigned max)
+{
+    unsigned n = 0;
+    for (unsigned i = 0; (i < _numof) && (n < max); ++i) {
+        if ((_targets[i].state == TARGET_DONE) ||
+            (_targets[i].state == TARGET_CACHED)) {
+            readings[n++] = _targets[i].reading;
+        }
+    }
+    return n;
+}
@@ -0,0 +1,200 @@
+/*
+ * Copyright (c) 2017 HAW Hamburg
+ *
+ * This file is subject to the terms and conditions of the GNU Lesser
+ * General Public License v2.1. See the file LICENSE in the top level
+ * directory for more details.
+ */
+
+/**
+ * @ingroup     vslab-riot
+ * @{
+ *
+ * @file
+ * @brief       Scatter-gather polling of sensor values
+ *
+ * The coordinator polls all clients of the registry once per round. At most
+ * @ref ELECT_POLL_WINDOW requests hold a gcoap memo at the same time, the
+ * window is refilled whenever a response or gcoap timeout releases one. A
+ * round is closed by @ref poll_finish at its deadline, nodes without an
+ * answer count as missed.
+ *
+ * Each client has its own request timeout, derived from a smoothed RTT and
+ * its variance like the RTO of TCP (RFC 6298). A request that is not
+ * answered in time is retried if a memo is free and another timeout fits
+ * into the round. The memo of the first request stays in the window until
+ * gcoap releases it, also into the next round, so polling never starves the
+ * other requests of the node. Clients missing @ref ELECT_POLL_DEMOTE rounds
+ * in a row are not polled for an exponentially growing number of rounds,
+ * so a few bad links do not hold the window of the whole round.
+ *
+ * @author      Sebastian Meiling <s@mlng.net>
+ */
+
+#ifndef POLL_H
+#define POLL_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "net/ipv6/addr.h"
+
+#include "elect.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#ifndef ELECT_POLL_WINDOW
+/**
+ * @brief Maximum number of gcoap memos held by sensor requests
+ *
+ * GCOAP_REQ_WAITING_MAX has to leave memos for the other requests besides a
+ * full window: one for a registration, push or snapshot fetch, and for a
+ * handover one for the state plus one per PUT of its clients, i.e.,
+ * ELECT_NODES_NUM / ELECT_COAP_NODES_PER_PUT rounded up. The application
+ * Makefile sizes it accordingly.
+ */
+#define ELECT_POLL_WINDOW       (4U)
+#endif
+
+#ifndef ELECT_POLL_DEADLINE
+/**
+ * @brief Time after which a polling round is closed in ms
+ *
+ * Scales with the election interval configured at runtime.
+ */
+#define ELECT_POLL_DEADLINE     (ELECT_MSG_INTERVAL / 2U)
+#endif
+
+/**
+ * @name Request timeouts in ms
+ * @{
+ */
+#ifndef ELECT_POLL_RTO_MIN
+#define ELECT_POLL_RTO_MIN      (50U)                   /**< lower bound */
+#endif
+#ifndef ELECT_POLL_RTO_INIT
+#define ELECT_POLL_RTO_INIT     (400U)                  /**< without RTT sample */
+#endif
+#ifndef ELECT_POLL_RTO_MAX
+#define ELECT_POLL_RTO_MAX      ELECT_POLL_DEADLINE     /**< upper bound, scales with the interval */
+#endif
+/** @} */
+
+#ifndef ELECT_POLL_RETRIES
+/**
+ * @brief Max. number of retries per client and round
+ */
+#define ELECT_POLL_RETRIES      (2U)
+#endif
+
+#ifndef ELECT_POLL_DEMOTE
+/**
+ * @brief Rounds in a row a client may miss before it is not polled anymore
+ */
+#define ELECT_POLL_DEMOTE       (3U)
+#endif
+
+#ifndef ELECT_POLL_DEMOTE_MAX
+/**
+ * @brief Max. number of rounds a demoted client is not polled
+ *
+ * A demoted client is not refreshed by answers. As rounds stretch with the
+ * interval, it is polled again regardless of this limit once it has been
+ * silent for half of @ref registry_max_age, so it gets a chance to answer
+ * before it is evicted.
+ */
+#define ELECT_POLL_DEMOTE_MAX   ((ELECT_LEADER_TIMEOUT / ELECT_MSG_INTERVAL) / 2U)
+#endif
+
+/**
+ * @brief Summary of a finished polling round
+ */
+typedef struct {
+    uint16_t numof;     /**< number of polled nodes */
+    uint16_t answered;  /**< number of nodes with a valid response */
+    uint16_t cached;    /**< number of nodes with a fresh cached value */
+    uint16_t missed;    /**< number of nodes without response */
+    uint16_t demoted;   /**< number of nodes not polled, see ELECT_POLL_DEMOTE */
+    uint32_t duration;  /**< time from start to last response in usec */
+} poll_report_t;
+
+/**
+ * @brief Initialise polling
+ *
+ * @param[in] main  PID of the main thread, receives @ref ELECT_POLL_RTO_EVENT
+ */
+void poll_init(kernel_pid_t main);
+
+/**
+ * @brief Start a new polling round over all registered nodes, an active
+ *        round is finished first
+ *
+ * Nodes with a fresh cached value, see @ref registry_fresh, are not polled.
+ *
+ * @param[in] deadline  end of the round in ms, see @ref elect_core_deadline
+ */
+void poll_start(uint32_t deadline);
+
+/**
+ * @brief Record a sensor response of a node
+ *
+ * The registry entry of the node is refreshed.
+ *
+ * @param[in] addr      address of the responding node
+ * @param[in] reading   sensor reading, all channels
+ *
+ * @returns true if the response belongs to the active round
+ */
+bool poll_response(const ipv6_addr_t *addr, const elect_reading_t *reading);
+
+/**
+ * @brief Record a sensor reading pushed by a node
+ *
+ * The reading is cached and used by the following rounds, until it expires.
+ *
+ * @param[in] addr      address of the node
+ * @param[in] reading   sensor reading, all channels
+ *
+ * @returns true if the node is registered
+ */
+bool poll_push(const ipv6_addr_t *addr, const elect_reading_t *reading);
+
+/**
+ * @brief Record a failed request and release its memo
+ *
+ * Called for every gcoap timeout, IDs of other requests are ignored.
+ *
+ * @param[in] msg_id    CoAP message ID of the request
+ */
+void poll_timeout(uint16_t msg_id);
+
+/**
+ * @brief Handle @ref ELECT_POLL_RTO_EVENT, retry or fail expired requests
+ */
+void poll_expire(void);
+
+/**
+ * @brief Close the active round and report nodes without answer
+ *
+ * @param[out] report   summary of the round
+ */
+void poll_finish(poll_report_t *report);
+
+/**
+ * @brief Copy sensor readings of the last round
+ *
+ * @param[out] readings destination buffer
+ * @param[in] max       size of @p readings
+ *
+ * @returns number of readings written
+ */
+unsigned poll_values(elect_reading_t *readings, unsigned max);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* POLL_H */
+/** @} */
@@ -0,0 +1,226 @@
+/*
+ * Copyright (c) 2017 HAW Hamburg
+ *
+ * This file is subject to the terms and conditions of the GNU Lesser
+ * General Public License v2.1. See the file LICENSE in the top level
+ * directory for more details.
+ */
+
+/**
+ * @ingroup     vslab-riot
+ * @{
+ *
+ * @file
+ * @brief       Registry of client nodes on the coordinator
+ *
+ * @author      Sebastian Meiling <s@mlng.net>
+ *
+ * @}
+ */
+
+#include <string.h>
+
+#include "log.h"
+#include "xtimer.h"
+
+#include "config.h"
+#include "registry.h"
+
+/**
+ * @name Bucket states
+ * @{
+ */
+#define BUCKET_EMPTY    (0)
+#define BUCKET_USED     (1)
+/** @} */
+
+static registry_entry_t _table[ELECT_REGISTRY_SIZE];
+static unsigned _numof;
+static uint16_t _epoch;
+
+static unsigned _hash(const ipv6_addr_t *addr)
+{
+    /* multiplicative hash over the folded interface identifier */
+    uint32_t h = (addr->u32[2] ^ addr->u32[3]) * 0x9e3779b1;
+    return (unsigned)(h % ELECT_REGISTRY_SIZE);
+}
+
+static registry_entry_t *_lookup(const ipv6_addr_t *addr,
+                                 registry_entry_t **free)
+{
+    unsigned idx = _hash(addr);
+    *free = NULL;
+    for (unsigned i = 0; i < ELECT_REGISTRY_SIZE; ++i) {
+        registry_entry_t *e = &_table[idx];
+        if (e->state == BUCKET_EMPTY) {
+            *free = e;
+            return NULL;
+        }
+        if (ipv6_addr_cmp(&e->addr, addr) == 0) {
+            return e;
+        }
+        idx = (idx + 1) % ELECT_REGISTRY_SIZE;
+    }
+    return NULL;
+}
+
+/* backward-shift deletion: move later entries of the probe chain into the
+ * hole, so a chain always ends at the first empty bucket */
+static void _delete(registry_entry_t *e)
+{
+    unsigned hole = (unsigned)(e - _table);
+    unsigned idx = (hole + 1) % ELECT_REGISTRY_SIZE;
+    while (_table[idx].state == BUCKET_USED) {
+        unsigned home = _hash(&_table[idx].addr);
+        /* the entry may move if the hole lies between its home and idx */
+        if (((idx + ELECT_REGISTRY_SIZE - home) % ELECT_REGISTRY_SIZE) >=
+            ((idx + ELECT_REGISTRY_SIZE - hole) % ELECT_REGISTRY_SIZE)) {
+            _table[hole] = _table[idx];
+            hole = idx;
+        }
+        idx = (idx + 1) % ELECT_REGISTRY_SIZE;
+    }
+    memset(&_table[hole], 0, sizeof(_table[hole]));
+    _numof--;
+}
+
+static void _evict_oldest(void)
+{
+    registry_entry_t *oldest = NULL;
+    uint32_t now = xtimer_now_usec();
+    for (unsigned i = 0; i < ELECT_REGISTRY_SIZE; ++i) {
+        registry_entry_t *e = &_table[i];
+        if ((e->state == BUCKET_USED) &&
+            ((oldest == NULL) ||
+             ((now - e->last_seen) > (now - oldest->last_seen)))) {
+            oldest = e;
+        }
+    }
+    if (oldest != NULL) {
+        LOG_WARNING("%s: registry full\n", __func__);
+        _delete(oldest);
+        _epoch++;
+    }
+}
+
+registry_entry_t *registry_add(const ipv6_addr_t *addr)
+{
+    registry_entry_t *free;
+    registry_entry_t *e = _lookup(addr, &free);
+    if (e == NULL) {
+        /* the configured limit may be lower than the capacity */
+        if (_numof >= (unsigned)config_get(ELECT_CONFIG_NODES)) {
+            _evict_oldest();
+            _lookup(addr, &free);
+        }
+        e = free;
+        memset(e, 0, sizeof(*e));
+        e->addr = *addr;
+        e->state = BUCKET_USED;
+        _numof++;
+        _epoch++;
+    }
+    e->last_seen = xtimer_now_usec();
+    return e;
+}
+
+registry_entry_t *registry_find(const ipv6_addr_t *addr)
+{
+    registry_entry_t *free;
+    return _lookup(addr, &free);
+}
+
+int registry_remove(const ipv6_addr_t *addr)
+{
+    registry_entry_t *e = registry_find(addr);
+    if (e == NULL) {
+        return 1;
+    }
+    _delete(e);
+    _epoch++;
+    return 0;
+}
+
+void registry_cache(registry_entry_t *e, const elect_reading_t *reading)
+{
+    e->last_seen = xtimer_now_usec();
+    e->fresh_until = e->last_seen +
+                     (config_scale(ELECT_SENSOR_MAX_AGE * MS_PER_SEC) * US_PER_MS);
+    e->reading = *reading;
+    e->cached = true;
+}
+
+bool registry_fresh(const registry_entry_t *e)
+{
+    return e->cached &&
+           ((int32_t)(e->fresh_until - xtimer_now_usec()) > 0);
+}
+
+uint32_t registry_max_age(void)
+{
+    return (uint32_t)(((uint64_t)ELECT_REGISTRY_MAX_AGE *
+                       (uint32_t)config_get(ELECT_CONFIG_TIMEOUT)) /
+                      ELECT_LEADER_TIMEOUT);
+}
+
+unsigned registry_evict(uint32_t max_age)
+{
+    unsigned evicted = 0;
+    uint32_t now = xtimer_now_usec();
+    for (unsigned i = 0; i < ELECT_REGISTRY_SIZE;) {
+        registry_entry_t *e = &_table[i];
+        if ((e->state == BUCKET_USED) &&
+            ((now - e->last_seen) > (max_age * US_PER_MS))) {
+            /* check the bucket again, a later entry may be shifted into it */
+            _delete(e);
+            evicted++;
+            continue;
+        }
+        ++i;
+    }
+    if (evicted > 0) {
+        _epoch++;
+    }
+    return evicted;
+}
+
+void registry_clear(void)
+{
+    if (_numof > 0) {
+        _epoch++;
+    }
+    memset(_table, 0, sizeof(_table));
+    _numof = 0;
+}
+
+unsigned registry_numof(void)
+{
+    return _numof;
+}
+
+uint16_t registry_epoch(void)
+{
+    return _epoch;
+}
+
+unsigned registry_addrs(ipv6_addr_t *addrs, unsigned max)
+{
+    unsigned n = 0;
+    for (unsigned i = 0; (i < ELECT_REGISTRY_SIZE) && (n < max); ++i) {
+        if (_table[i].state == BUCKET_USED) {
+            addrs[n++] = _table[i].addr;
+        }
+    }
+    return n;
+}
+
+registry_entry_t *registry_iter(const registry_entry_t *last)
+{
+    unsigned i = (last == NULL) ? 0 : (unsigned)(last - _table) + 1;
+    for (; i < ELECT_REGISTRY_SIZE; ++i) {
+        if (_table[i].state == BUCKET_USED) {
+            return &_table[i];
+        }
+    }
+    return NULL;
+}
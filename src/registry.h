@@ -0,0 +1,177 @@
+/*
+ * Copyright (c) 2017 HAW Hamburg
+ *
+ * This file is subject to the terms and conditions of the GNU Lesser
+ * General Public License v2.1. See the file LICENSE in the top level
+ * directory for more details.
+ */
+
+/**
+ * @ingroup     vslab-riot
+ * @{
+ *
+ * @file
+ * @brief       Registry of client nodes on the coordinator
+ *
+ * Open addressing hash table with linear probing, keyed by the interface
+ * identifier of the node address. The table has room for
+ * @ref ELECT_NODES_NUM nodes and is kept at most half full. Removal shifts
+ * later entries of a probe chain back instead of leaving tombstones, so a
+ * miss never probes further than the next empty bucket. Entries may move
+ * on removal, pointers are only valid until the next change.
+ *
+ * @author      Sebastian Meiling <s@mlng.net>
+ */
+
+#ifndef REGISTRY_H
+#define REGISTRY_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "net/ipv6/addr.h"
+
+#include "elect.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * @brief Number of buckets of the hash table
+ */
+#define ELECT_REGISTRY_SIZE     (2 * ELECT_NODES_NUM)
+
+#ifndef ELECT_REGISTRY_MAX_AGE
+/**
+ * @brief Time in ms after which a silent node is evicted
+ *
+ * Scales with the leader timeout configured at runtime.
+ */
+#define ELECT_REGISTRY_MAX_AGE  (2U * ELECT_LEADER_TIMEOUT)
+#endif
+
+/**
+ * @brief Entry of a registered node
+ */
+typedef struct {
+    ipv6_addr_t addr;       /**< address of the node */
+    uint32_t last_seen;     /**< time of last registration or answer in usec */
+    uint16_t answers;       /**< number of answered sensor requests */
+    uint16_t misses;        /**< number of missed sensor requests */
+    uint32_t fresh_until;   /**< end of validity of @ref reading in usec */
+    elect_reading_t reading;    /**< last sensor reading of the node */
+    bool cached;            /**< @ref reading was set */
+    uint32_t srtt;          /**< smoothed RTT in usec, 0 without sample */
+    uint32_t rttvar;        /**< RTT variation in usec */
+    uint8_t backoff;        /**< timeouts since last RTT sample */
+    uint8_t fails;          /**< rounds missed in a row */
+    uint8_t skip;           /**< rounds left without polling */
+    uint8_t state;          /**< bucket state, internal */
+} registry_entry_t;
+
+/**
+ * @brief Add a node or refresh its entry
+ *
+ * If the registry is full, the entry seen least recently is evicted.
+ *
+ * @param[in] addr  address of the node
+ *
+ * @returns entry of the node
+ */
+registry_entry_t *registry_add(const ipv6_addr_t *addr);
+
+/**
+ * @brief Find the entry of a node
+ *
+ * @param[in] addr  address of the node
+ *
+ * @returns entry of the node, NULL if not registered
+ */
+registry_entry_t *registry_find(const ipv6_addr_t *addr);
+
+/**
+ * @brief Remove a node
+ *
+ * @param[in] addr  address of the node
+ *
+ * @returns 0 on success, 1 if the node was not registered
+ */
+int registry_remove(const ipv6_addr_t *addr);
+
+/**
+ * @brief Store the sensor reading of a node
+ *
+ * The reading is valid for @ref ELECT_SENSOR_MAX_AGE, scaled with the
+ * interval configured at runtime, the entry is refreshed.
+ *
+ * @param[in] e         entry of the node
+ * @param[in] reading   sensor reading, all channels
+ */
+void registry_cache(registry_entry_t *e, const elect_reading_t *reading);
+
+/**
+ * @brief Check if the cached sensor value of a node is still valid
+ *
+ * @param[in] e         entry of the node
+ *
+ * @returns true if the value can be used instead of a request
+ */
+bool registry_fresh(const registry_entry_t *e);
+
+/**
+ * @brief Get ELECT_REGISTRY_MAX_AGE scaled to the configured leader timeout
+ *
+ * @returns maximum age in ms
+ */
+uint32_t registry_max_age(void);
+
+/**
+ * @brief Remove all nodes not seen for more than @p max_age ms
+ *
+ * @param[in] max_age   maximum age in ms
+ *
+ * @returns number of evicted nodes
+ */
+unsigned registry_evict(uint32_t max_age);
+
+/**
+ * @brief Remove all nodes
+ */
+void registry_clear(void);
+
+/**
+ * @brief Number of registered nodes
+ */
+unsigned registry_numof(void);
+
+/**
+ * @brief Membership epoch, changes whenever a node is added or removed
+ */
+uint16_t registry_epoch(void);
+
+/**
+ * @brief Copy the addresses of all registered nodes
+ *
+ * @param[out] addrs    destination buffer
+ * @param[in] max       size of @p addrs
+ *
+ * @returns number of addresses written
+ */
+unsigned registry_addrs(ipv6_addr_t *addrs, unsigned max);
+
+/**
+ * @brief Iterate over all registered nodes
+ *
+ * @param[in] last  previous entry, NULL to get the first one
+ *
+ * @returns next entry, NULL if there is none
+ */
+registry_entry_t *registry_iter(const registry_entry_t *last);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* REGISTRY_H */
+/** @} */
@@ -0,0 +1,96 @@
+/*
+ * Copyright (c) 2017 HAW Hamburg
+ *
+ * This file is subject to the terms and conditions of the GNU Lesser
+ * General Public License v2.1. See the file LICENSE in the top level
+ * directory for more details.
+ */
+
+/**
+ * @ingroup     vslab-riot
+ * @{
+ *
+ * @file
+ * @brief       Pool of reference counted receive slots
+ *
+ * @author      Sebastian Meiling <s@mlng.net>
+ *
+ * @}
+ */
+
+#include <string.h>
+
+#include "irq.h"
+#include "log.h"
+#include "xtimer.h"
+
+#include "rxpool.h"
+
+static rxpool_slot_t _slots[ELECT_RXPOOL_NUMOF];
+static unsigned _drops;
+
+rxpool_slot_t *rxpool_alloc(void)
+{
+    rxpool_slot_t *slot = NULL;
+    unsigned state = irq_disable();
+    for (unsigned i = 0; i < ELECT_RXPOOL_NUMOF; ++i) {
+        if (_slots[i].refs == 0) {
+            slot = &_slots[i];
+            slot->refs = 1;
+            break;
+        }
+    }
+    if (slot == NULL) {
+        _drops++;
+    }
+    irq_restore(state);
+
+    if (slot == NULL) {
+        LOG_WARNING("%s: pool exhausted!\n", __func__);
+        return NULL;
+    }
+    slot->len = 0;
+    slot->time = xtimer_now_usec();
+    memset(&slot->remote, 0, sizeof(slot->remote));
+    return slot;
+}
+
+rxpool_slot_t *rxpool_put(const void *data, size_t len,
+                          const sock_udp_ep_t *remote)
+{
+    rxpool_slot_t *slot = rxpool_alloc();
+    if (slot == NULL) {
+        return NULL;
+    }
+    if (len >= sizeof(slot->data)) {
+        len = sizeof(slot->data) - 1;
+    }
+    memcpy(slot->data, data, len);
+    slot->data[len] = '\0';
+    slot->len = (uint8_t)len;
+    if (remote != NULL) {
+        memcpy(&slot->remote, remote, sizeof(slot->remote));
+    }
+    return slot;
+}
+
+void rxpool_hold(rxpool_slot_t *slot)
+{
+    unsigned state = irq_disable();
+    slot->refs++;
+    irq_restore(state);
+}
+
+void rxpool_release(rxpool_slot_t *slot)
+{
+    unsigned state = irq_disable();
+    if (slot->refs > 0) {
+        slot->refs--;
+    }
+    irq_restore(state);
+}
+
+unsigned rxpool_drops(void)
+{
+    return _drops;
+}
@@ -0,0 +1,107 @@
+/*
+ * Copyright (c) 2017 HAW Hamburg
+ *
+ * This file is subject to the terms and conditions of the GNU Lesser
+ * General Public License v2.1. See the file LICENSE in the top level
+ * directory for more details.
+ */
+
+/**
+ * @ingroup     vslab-riot
+ * @{
+ *
+ * @file
+ * @brief       Pool of reference counted receive slots
+ *
+ * Received datagrams and CoAP payloads are stored in slots of a static pool
+ * and handed to the main thread by reference, see evq.h. The producer allocates a slot,
+ * fills it and passes ownership of its reference on; whoever drops the last
+ * reference returns the slot to the pool.
+ *
+ * @author      Sebastian Meiling <s@mlng.net>
+ */
+
+#ifndef RXPOOL_H
+#define RXPOOL_H
+
+#include <stdint.h>
+#include <stddef.h>
+
+#include "net/sock/udp.h"
+
+#include "elect.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#ifndef ELECT_RXPOOL_NUMOF
+/**
+ * @brief Number of receive slots, should be at least ELECT_EVQ_SIZE / 2
+ */
+#define ELECT_RXPOOL_NUMOF      (16U)
+#endif
+
+/**
+ * @brief Payload size of a slot, fits a text IPv6 address and a NUL byte
+ */
+#define ELECT_RXPOOL_SLOT_SIZE  (IPV6_ADDR_MAX_STR_LEN + 2)
+
+/**
+ * @brief Receive slot
+ */
+typedef struct {
+    uint8_t refs;                           /**< reference count, 0 if free */
+    uint8_t len;                            /**< length of data */
+    uint32_t time;                          /**< arrival time in usec */
+    sock_udp_ep_t remote;                   /**< sender endpoint */
+    uint8_t data[ELECT_RXPOOL_SLOT_SIZE];   /**< received data */
+} rxpool_slot_t;
+
+/**
+ * @brief Get a free slot, with one reference held by the caller
+ *
+ * @returns slot on success, NULL if the pool is exhausted
+ */
+rxpool_slot_t *rxpool_alloc(void);
+
+/**
+ * @brief Get a slot and fill it with a copy of @p data
+ *
+ * Data is truncated to fit the slot and always NUL terminated, so text
+ * payloads can be used as string directly.
+ *
+ * @param[in] data      payload to copy
+ * @param[in] len       length of @p data
+ * @param[in] remote    sender endpoint, may be NULL
+ *
+ * @returns slot on success, NULL if the pool is exhausted
+ */
+rxpool_slot_t *rxpool_put(const void *data, size_t len,
+                          const sock_udp_ep_t *remote);
+
+/**
+ * @brief Take an additional reference on @p slot
+ *
+ * @param[in] slot  slot in use
+ */
+void rxpool_hold(rxpool_slot_t *slot);
+
+/**
+ * @brief Drop a reference on @p slot, freeing it with the last one
+ *
+ * @param[in] slot  slot in use
+ */
+void rxpool_release(rxpool_slot_t *slot);
+
+/**
+ * @brief Number of allocations failed since boot, because the pool was empty
+ */
+unsigned rxpool_drops(void);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* RXPOOL_H */
+/** @} */
@@ -11,14 +11,17 @@
  * @{
  *
  * @file
- * @brief       Sensor wrapper code
+ * @brief       Sensor wrapper code, channels and drivers
  *
  * @author      Sebastian Meiling <s@mlng.net>
  *
  * @}
  */
 
+#include "irq.h"
 #include "log.h"
+#include "thread.h"
+#include "xtimer.h"
 #ifdef MODULE_HDC1000
 #include "hdc1000.h"
 #include "hdc1000_params.h"
@@ -27,8 +30,48 @@ static hdc1000_t dev_hdc1000;
 #include "random.h"
 #endif
 
+#include "config.h"
 #include "elect.h"
+#include "evq.h"
+#include "sensor.h"
+#include "series.h"
 
+#define SENSOR_STACKSIZE        (THREAD_STACKSIZE_DEFAULT)
+#define SENSOR_MASK_ALL         ((1U << ELECT_CHANNEL_NUMOF) - 1)
+
+static const sensor_channel_t _channels[ELECT_CHANNEL_NUMOF] = {
+    [ELECT_CHANNEL_TEMP] = {
+        .name = "T", .unit = "C", .scale = 100, .every = 1,
+        .threshold = ELECT_SENSOR_THRESHOLD,
+    },
+    [ELECT_CHANNEL_HUM] = {
+        .name = "H", .unit = "%", .scale = 100, .every = ELECT_SENSOR_HUM_EVERY,
+        .threshold = ELECT_SENSOR_HUM_THRESHOLD,
+    },
+};
+
+#ifdef MODULE_HDC1000
+static int _hdc1000_init(void)
+{
+    return (hdc1000_init(&dev_hdc1000, &hdc1000_params[0]) == HDC1000_OK) ? 0 : 1;
+}
+
+/* one conversion delivers both, a channel not due is not transferred */
+static int _hdc1000_read(uint8_t mask, int16_t *values)
+{
+    hdc1000_read(&dev_hdc1000,
+                 (mask & (1U << ELECT_CHANNEL_TEMP)) ? &values[ELECT_CHANNEL_TEMP] : NULL,
+                 (mask & (1U << ELECT_CHANNEL_HUM)) ? &values[ELECT_CHANNEL_HUM] : NULL);
+    return 0;
+}
+
+static const sensor_driver_t _driver = {
+    .name = "hdc1000",
+    .channels = SENSOR_MASK_ALL,
+    .init = _hdc1000_init,
+    .read = _hdc1000_read,
+};
+#else
 /**
  * @name Sensor value ranges for dummy device
  * @{
@@ -40,49 +83,196 @@ static hdc1000_t dev_hdc1000;
 #define ELECT_SENSOR_HUM_MAX    (8000U)
 /** @} */
 
-/**
- * @brief Weight for average sensor values if dummy device is used
- *
- * For the dummy sensor device values are generated by a random function, to
- * avoid irratic value jumps a weighted average is calculated as follows:
- *
- * AVG = (((ELECT_SENSOR_ALPHA - 1) * VAL(n)) + VAL(n+1)) / ELECT_SENSOR_ALPHA
- */
-#define ELECT_SENSOR_ALPHA      (4U)
+static const uint16_t _dummy_range[ELECT_CHANNEL_NUMOF][2] = {
+    [ELECT_CHANNEL_TEMP] = { ELECT_SENSOR_TEMP_MIN, ELECT_SENSOR_TEMP_MAX },
+    [ELECT_CHANNEL_HUM] = { ELECT_SENSOR_HUM_MIN, ELECT_SENSOR_HUM_MAX },
+};
+static int16_t _dummy[ELECT_CHANNEL_NUMOF];
+
+static int _dummy_init(void)
+{
+    for (unsigned ch = 0; ch < ELECT_CHANNEL_NUMOF; ch++) {
+        _dummy[ch] = (int16_t)random_uint32_range(_dummy_range[ch][0],
+                                                  _dummy_range[ch][1]);
+    }
+    return 0;
+}
+
+static int _dummy_read(uint8_t mask, int16_t *values)
+{
+    int32_t alpha = config_get(ELECT_CONFIG_ALPHA);
+    for (unsigned ch = 0; ch < ELECT_CHANNEL_NUMOF; ch++) {
+        if (!(mask & (1U << ch))) {
+            continue;
+        }
+        _dummy[ch] = (((alpha - 1) * _dummy[ch]) +
+                      (int32_t)random_uint32_range(_dummy_range[ch][0],
+                                                   _dummy_range[ch][1])) / alpha;
+        values[ch] = _dummy[ch];
+    }
+    return 0;
+}
+
+static const sensor_driver_t _driver = {
+    .name = "dummy",
+    .channels = SENSOR_MASK_ALL,
+    .init = _dummy_init,
+    .read = _dummy_read,
+};
+#endif /* MODULE_HDC1000 */
+
+static char _stack[SENSOR_STACKSIZE];
+static kernel_pid_t _pid = KERNEL_PID_UNDEF;
+
+/* raw samples of the current interval per channel, owned by the sampling
+ * thread */
+static int16_t _ring[ELECT_CHANNEL_NUMOF][ELECT_SENSOR_OVERSAMPLE];
+static unsigned _ring_pos[ELECT_CHANNEL_NUMOF];
+static uint32_t _tick;
+
+/* published reading, read from any thread with interrupts disabled */
+static elect_reading_t _published;
+
+/* read all channels due in this period in one driver transaction */
+static uint8_t _sample(int16_t *raw)
+{
+    uint8_t mask = 0;
+    for (unsigned ch = 0; ch < ELECT_CHANNEL_NUMOF; ch++) {
+        if ((_tick % _channels[ch].every) == 0) {
+            mask |= (1U << ch);
+        }
+    }
+    _tick++;
+    mask &= _driver.channels;
+    if ((mask == 0) || (_driver.read(mask, raw) != 0)) {
+        return 0;
+    }
+    LOG_DEBUG("%s: raw T: %"PRIi16", H: %"PRIi16" (mask 0x%x)\n", __func__,
+              raw[ELECT_CHANNEL_TEMP], raw[ELECT_CHANNEL_HUM], (unsigned)mask);
+    return mask;
+}
+
+/* decimate a ring to a single value, a plain mean over the interval */
+static int16_t _decimate(const int16_t *ring)
+{
+    int32_t sum = 0;
+    for (unsigned i = 0; i < ELECT_SENSOR_OVERSAMPLE; ++i) {
+        sum += ring[i];
+    }
+    return (int16_t)(sum / (int32_t)ELECT_SENSOR_OVERSAMPLE);
+}
 
-static int16_t temp, hum;
+#if ELECT_SERIES
+#define SERIES_EVERY    (ELECT_SERIES_INTERVAL / ELECT_SENSOR_SAMPLE_INTERVAL)
+
+#if (SERIES_EVERY < 1)
+#error "ELECT_SERIES_INTERVAL must not be shorter than ELECT_SENSOR_SAMPLE_INTERVAL"
+#endif
+
+/* store the mean of the published readings of every series interval */
+static void _store(const elect_reading_t *reading)
+{
+    static int32_t temp_sum, hum_sum;
+    static unsigned n;
+    temp_sum += reading->values[ELECT_CHANNEL_TEMP];
+    hum_sum += reading->values[ELECT_CHANNEL_HUM];
+    if (++n < SERIES_EVERY) {
+        return;
+    }
+    series_add((uint32_t)(xtimer_now_usec64() / US_PER_SEC),
+               (int16_t)(temp_sum / (int32_t)n), (int16_t)(hum_sum / (int32_t)n));
+    temp_sum = 0;
+    hum_sum = 0;
+    n = 0;
+}
+#endif
+
+/* raw sampling period in usec, scaled to the runtime interval */
+static uint32_t _period(void)
+{
+    return (config_scale(ELECT_SENSOR_SAMPLE_INTERVAL) * US_PER_MS) /
+           ELECT_SENSOR_OVERSAMPLE;
+}
+
+static void *_sample_loop(void *arg)
+{
+    (void)arg;
+    xtimer_ticks32_t last = xtimer_now();
+    while (1) {
+        xtimer_periodic_wakeup(&last, _period());
+        int16_t raw[ELECT_CHANNEL_NUMOF] = { 0 };
+        uint8_t mask = _sample(raw);
+        bool complete = false;
+        for (unsigned ch = 0; ch < ELECT_CHANNEL_NUMOF; ch++) {
+            if (!(mask & (1U << ch))) {
+                continue;
+            }
+            _ring[ch][_ring_pos[ch]] = raw[ch];
+            if (++_ring_pos[ch] < ELECT_SENSOR_OVERSAMPLE) {
+                continue;
+            }
+            _ring_pos[ch] = 0;
+            int16_t value = _decimate(_ring[ch]);
+            unsigned state = irq_disable();
+            _published.values[ch] = value;
+            irq_restore(state);
+            /* the temperature completes every interval, so do readings */
+            complete |= (ch == ELECT_CHANNEL_TEMP);
+        }
+        if (!complete) {
+            continue;
+        }
+        evq_post_type(ELECT_SENSOR_SAMPLE_EVENT);
+#if ELECT_SERIES
+        elect_reading_t reading;
+        sensor_read(&reading);
+        _store(&reading);
+#endif
+    }
+    /* never reached */
+    return NULL;
+}
 
 int sensor_init(void)
 {
-    LOG_DEBUG("%s: begin\n", __func__);
-#ifdef MODULE_HDC1000
-    /* initialise humidity sensor hdc1000 */
-    if (hdc1000_init(&dev_hdc1000, &hdc1000_params[0]) != HDC1000_OK) {
+    LOG_DEBUG("%s: begin (%s)\n", __func__, _driver.name);
+    if (_driver.init() != 0) {
         LOG_ERROR("%s: init fail!\n", __func__);
         return 1;
     }
-    hdc1000_read(&dev_hdc1000, &temp, &hum);
-#else
-    temp = (int16_t)random_uint32_range(ELECT_SENSOR_TEMP_MIN, ELECT_SENSOR_TEMP_MAX);
-    hum  = (int16_t)random_uint32_range(ELECT_SENSOR_HUM_MIN, ELECT_SENSOR_HUM_MAX);
-#endif /* MODULE_HDC1000 */
-    LOG_DEBUG("%s: raw T: %"PRIi16", H: %"PRIi16"\n", __func__, temp, hum);
+    int16_t raw[ELECT_CHANNEL_NUMOF];
+    if (_driver.read(_driver.channels, raw) != 0) {
+        LOG_ERROR("%s: read fail!\n", __func__);
+        return 1;
+    }
+    for (unsigned ch = 0; ch < ELECT_CHANNEL_NUMOF; ch++) {
+        _published.values[ch] = (_driver.channels & (1U << ch))
+                              ? raw[ch] : ELECT_VALUE_NONE;
+    }
+    LOG_DEBUG("%s: raw T: %"PRIi16", H: %"PRIi16"\n", __func__,
+              raw[ELECT_CHANNEL_TEMP], raw[ELECT_CHANNEL_HUM]);
+    if (_pid <= KERNEL_PID_UNDEF) {
+        /* below main, a conversion only delays other sampling */
+        _pid = thread_create(_stack, sizeof(_stack), (THREAD_PRIORITY_MAIN + 1),
+                             THREAD_CREATE_STACKTEST, _sample_loop, NULL,
+                             "sensor");
+        if (_pid <= KERNEL_PID_UNDEF) {
+            LOG_ERROR("%s: can not start sampling thread!\n", __func__);
+            return 1;
+        }
+    }
     LOG_DEBUG("%s: done\n", __func__);
     return 0;
 }
 
-int16_t sensor_read(void)
+void sensor_read(elect_reading_t *reading)
 {
-    LOG_DEBUG("%s: begin\n", __func__);
-#ifdef MODULE_HDC1000
-    hdc1000_read(&dev_hdc1000, &temp, &hum);
-#else
-    temp = (((ELECT_SENSOR_ALPHA - 1) * temp) +
-            (int16_t)random_uint32_range(ELECT_SENSOR_TEMP_MIN, ELECT_SENSOR_TEMP_MAX)) / ELECT_SENSOR_ALPHA;
-    hum  = (((ELECT_SENSOR_ALPHA - 1) * hum)  +
-            (int16_t)random_uint32_range(ELECT_SENSOR_HUM_MIN, ELECT_SENSOR_HUM_MAX)) / ELECT_SENSOR_ALPHA;
-#endif /* MODULE_HDC1000 */
-    LOG_DEBUG("%s: raw T: %"PRIi16", H: %"PRIi16"\n", __func__, temp, hum);
-    LOG_DEBUG("%s: done\n", __func__);
-    return temp;
+    unsigned state = irq_disable();
+    *reading = _published;
+    irq_restore(state);
+}
+
+const sensor_channel_t *sensor_channel(unsigned ch)
+{
+    return (ch < ELECT_CHANNEL_NUMOF) ? &_channels[ch] : NULL;
 }
@@ -0,0 +1,95 @@
+/*
+ * Copyright (c) 2017 HAW Hamburg
+ *
+ * This file is subject to the terms and conditions of the GNU Lesser
+ * General Public License v2.1. See the file LICENSE in the top level
+ * directory for more details.
+ */
+
+/**
+ * @ingroup     vslab-riot
+ * @{
+ *
+ * @file
+ * @brief       Sensor channels and drivers
+ *
+ * Every channel of @ref elect_reading_t is described by a static table entry
+ * with its name, scale, sampling rate and push threshold. A driver reads all
+ * channels due in one period in a single transaction, e.g. hdc1000 converts
+ * temperature and humidity together. Without a sensor module a dummy driver
+ * generates smoothed random values.
+ *
+ * @author      Sebastian Meiling <s@mlng.net>
+ */
+
+#ifndef SENSOR_H
+#define SENSOR_H
+
+#include <stdint.h>
+
+#include "elect.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#ifndef ELECT_SENSOR_HUM_EVERY
+/**
+ * @brief Humidity is sampled every n-th period of the temperature, it
+ *        changes slowly
+ */
+#define ELECT_SENSOR_HUM_EVERY  (2U)
+#endif
+
+#ifndef ELECT_SENSOR_ALPHA
+/**
+ * @brief Weight for average sensor values if dummy device is used
+ *
+ * For the dummy sensor device values are generated by a random function, to
+ * avoid irratic value jumps a weighted average is calculated as follows:
+ *
+ * AVG = (((ELECT_SENSOR_ALPHA - 1) * VAL(n)) + VAL(n+1)) / ELECT_SENSOR_ALPHA
+ *
+ * This is the default, it can be changed at runtime, see config.h.
+ */
+#define ELECT_SENSOR_ALPHA      (4U)
+#endif
+
+/**
+ * @brief Description of a sensor channel
+ */
+typedef struct {
+    const char *name;   /**< short name, e.g. for logs */
+    const char *unit;   /**< unit of the physical value */
+    uint16_t scale;     /**< a value is the physical value times scale */
+    uint8_t every;      /**< sampled every n-th raw sampling period */
+    int16_t threshold;  /**< change of a value to push it */
+} sensor_channel_t;
+
+/**
+ * @brief Sensor driver
+ */
+typedef struct {
+    const char *name;   /**< name of the driver */
+    uint8_t channels;   /**< bitmask of the channels provided */
+    /** initialise the device, returns 0 on success */
+    int (*init)(void);
+    /** read the channels in @p mask in one transaction, returns 0 on success */
+    int (*read)(uint8_t mask, int16_t *values);
+} sensor_driver_t;
+
+/**
+ * @brief Get the description of a channel
+ *
+ * @param[in] ch    channel, see @ref ELECT_CHANNEL_TEMP
+ *
+ * @returns description, NULL if @p ch is out of range
+ */
+const sensor_channel_t *sensor_channel(unsigned ch);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* SENSOR_H */
+/** @} */
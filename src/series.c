@@ -0,0 +1,219 @@
+/*
+ * Copyright (c) 2017 HAW Hamburg
+ *
+ * This file is subject to the terms and conditions of the GNU Lesser
+ * General Public License v2.1. See the file LICENSE in the top level
+ * directory for more details.
+ */
+
+/**
+ * @ingroup     vslab-riot
+ * @{
+ *
+ * @file
+ * @brief       Compressed history of the local sensor values
+ *
+ * @author      Sebastian Meiling <s@mlng.net>
+ *
+ * @}
+ */
+
+#include <string.h>
+
+#include "series.h"
+
+#if ELECT_SERIES
+
+#include "mutex.h"
+
+#if (ELECT_SERIES_BLOCK_SIZE > 255)
+#error "ELECT_SERIES_BLOCK_SIZE must not exceed 255"
+#endif
+
+/* max. length of an encoded sample, three varints of 32 bit */
+#define SAMPLE_MAX_LEN  (15U)
+
+/* state of the last sample, to encode or decode the next one */
+typedef struct {
+    uint32_t time;
+    int32_t delta;
+    int16_t temp;
+    int16_t hum;
+} _last_t;
+
+static series_block_t _ring[ELECT_SERIES_BLOCKS];
+/* blocks started since boot, the current one is (_total - 1) % BLOCKS */
+static uint32_t _total;
+static _last_t _last;
+static mutex_t _lock = MUTEX_INIT;
+
+static inline uint32_t _zigzag(int32_t v)
+{
+    return ((uint32_t)v << 1) ^ (uint32_t)(v >> 31);
+}
+
+static inline int32_t _unzigzag(uint32_t v)
+{
+    return (int32_t)(v >> 1) ^ -(int32_t)(v & 1);
+}
+
+static size_t _varint_put(uint8_t *buf, uint32_t v)
+{
+    size_t n = 0;
+    while (v >= 0x80) {
+        buf[n++] = (uint8_t)(v | 0x80);
+        v >>= 7;
+    }
+    buf[n++] = (uint8_t)v;
+    return n;
+}
+
+/* returns bytes read, 0 if the varint exceeds @p len */
+static size_t _varint_get(const uint8_t *buf, size_t len, uint32_t *v)
+{
+    *v = 0;
+    for (size_t n = 0; (n < len) && (n < 5); n++) {
+        *v |= (uint32_t)(buf[n] & 0x7f) << (7 * n);
+        if (!(buf[n] & 0x80)) {
+            return n + 1;
+        }
+    }
+    return 0;
+}
+
+static void _block_start(uint32_t time, int16_t temp, int16_t hum)
+{
+    series_block_t *b = &_ring[_total++ % ELECT_SERIES_BLOCKS];
+    b->start = time;
+    b->temp = temp;
+    b->hum = hum;
+    b->count = 1;
+    b->len = 0;
+    _last.time = time;
+    _last.delta = 0;
+    _last.temp = temp;
+    _last.hum = hum;
+}
+
+void series_add(uint32_t time, int16_t temp, int16_t hum)
+{
+    mutex_lock(&_lock);
+    if (_total == 0) {
+        _block_start(time, temp, hum);
+        mutex_unlock(&_lock);
+        return;
+    }
+    series_block_t *b = &_ring[(_total - 1) % ELECT_SERIES_BLOCKS];
+    int32_t delta = (int32_t)(time - _last.time);
+    uint8_t enc[SAMPLE_MAX_LEN];
+    size_t len = _varint_put(enc, _zigzag(delta - _last.delta));
+    len += _varint_put(&enc[len], _zigzag((int32_t)temp - _last.temp));
+    len += _varint_put(&enc[len], _zigzag((int32_t)hum - _last.hum));
+    if ((b->len + len > ELECT_SERIES_BLOCK_SIZE) || (b->count == UINT16_MAX)) {
+        _block_start(time, temp, hum);
+        mutex_unlock(&_lock);
+        return;
+    }
+    memcpy(&b->data[b->len], enc, len);
+    b->len += len;
+    b->count++;
+    _last.time = time;
+    _last.delta = delta;
+    _last.temp = temp;
+    _last.hum = hum;
+    mutex_unlock(&_lock);
+}
+
+unsigned series_blocks(void)
+{
+    mutex_lock(&_lock);
+    unsigned numof = (_total < ELECT_SERIES_BLOCKS) ? _total : ELECT_SERIES_BLOCKS;
+    mutex_unlock(&_lock);
+    return numof;
+}
+
+bool series_get(unsigned i, series_block_t *block)
+{
+    bool res = false;
+    mutex_lock(&_lock);
+    uint32_t numof = (_total < ELECT_SERIES_BLOCKS) ? _total : ELECT_SERIES_BLOCKS;
+    if (i < numof) {
+        *block = _ring[(_total - numof + i) % ELECT_SERIES_BLOCKS];
+        res = true;
+    }
+    mutex_unlock(&_lock);
+    return res;
+}
+
+int series_decode(const series_block_t *block, series_cb_t cb, void *ctx)
+{
+    _last_t last = {
+        .time = block->start, .delta = 0,
+        .temp = block->temp, .hum = block->hum,
+    };
+    size_t pos = 0;
+
+    if (block->count == 0) {
+        return 0;
+    }
+    cb(ctx, last.time, last.temp, last.hum);
+    for (unsigned i = 1; i < block->count; i++) {
+        uint32_t v[3];
+        for (unsigned j = 0; j < 3; j++) {
+            size_t n = _varint_get(&block->data[pos], block->len - pos, &v[j]);
+            if (n == 0) {
+                return 1;
+            }
+            pos += n;
+        }
+        last.delta += _unzigzag(v[0]);
+        last.time += last.delta;
+        last.temp += _unzigzag(v[1]);
+        last.hum += _unzigzag(v[2]);
+        cb(ctx, last.time, last.temp, last.hum);
+    }
+    return 0;
+}
+
+/* mean of every step samples, passed on to the callback of series_read */
+typedef struct {
+    series_cb_t cb;
+    void *ctx;
+    unsigned step;
+    unsigned n;
+    unsigned out;
+    int32_t temp;
+    int32_t hum;
+} _down_t;
+
+static void _down(void *ctx, uint32_t time, int16_t temp, int16_t hum)
+{
+    _down_t *d = ctx;
+    d->temp += temp;
+    d->hum += hum;
+    if (++d->n < d->step) {
+        return;
+    }
+    d->cb(d->ctx, time, (int16_t)(d->temp / (int32_t)d->n),
+          (int16_t)(d->hum / (int32_t)d->n));
+    d->out++;
+    d->n = 0;
+    d->temp = 0;
+    d->hum = 0;
+}
+
+unsigned series_read(unsigned step, series_cb_t cb, void *ctx)
+{
+    _down_t d = { .cb = cb, .ctx = ctx, .step = (step > 0) ? step : 1 };
+    series_block_t block;
+
+    for (unsigned i = 0; series_get(i, &block); i++) {
+        /* a corrupt block ends early, the others are still read */
+        series_decode(&block, _down, &d);
+    }
+    return d.out;
+}
+
+#else
+typedef int dont_be_pedantic;
+#endif /* ELECT_SERIES */
@@ -0,0 +1,165 @@
+/*
+ * Copyright (c) 2017 HAW Hamburg
+ *
+ * This file is subject to the terms and conditions of the GNU Lesser
+ * General Public License v2.1. See the file LICENSE in the top level
+ * directory for more details.
+ */
+
+/**
+ * @ingroup     vslab-riot
+ * @{
+ *
+ * @file
+ * @brief       Compressed history of the local sensor values
+ *
+ * Temperature and humidity are stored every @ref ELECT_SERIES_INTERVAL in a
+ * ring of fixed size blocks. The first sample of a block is kept as is in
+ * its header, each following one is encoded as delta-of-delta of its time
+ * and deltas of its values, zigzag mapped to unsigned and written as
+ * varints. With a steady interval and slowly changing values a sample takes
+ * 3 to 5 bytes, so a few KB hold hours of history. When the ring is full,
+ * the oldest block is dropped.
+ *
+ * Blocks never change once they are full, so they could be written to
+ * flash pages as is.
+ *
+ * @author      Sebastian Meiling <s@mlng.net>
+ */
+
+#ifndef SERIES_H
+#define SERIES_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#include "elect.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#ifndef ELECT_SERIES
+/**
+ * @brief Keep the history of the local sensor and serve `/series`
+ */
+#define ELECT_SERIES            (1)
+#endif
+
+#ifndef ELECT_SERIES_INTERVAL
+/**
+ * @brief Interval between two stored samples in ms, a multiple of
+ *        ELECT_SENSOR_SAMPLE_INTERVAL, scales with it at runtime
+ */
+#define ELECT_SERIES_INTERVAL   (5U * ELECT_SENSOR_SAMPLE_INTERVAL)
+#endif
+
+#ifndef ELECT_SERIES_BLOCK_SIZE
+/**
+ * @brief Size of the encoded samples of a block in bytes, max. 255
+ */
+#define ELECT_SERIES_BLOCK_SIZE (128U)
+#endif
+
+#ifndef ELECT_SERIES_BLOCKS
+/**
+ * @brief Number of blocks in the ring
+ */
+#define ELECT_SERIES_BLOCKS     (16U)
+#endif
+
+/**
+ * @name Encoding of the history served at GET `/series`
+ *
+ * Header: version (1), format (1), number of blocks or records (2), current
+ * time in s (4). Without query the blocks follow as stored, oldest first:
+ * time of the first sample in s (4), temperature (2), humidity (2), number
+ * of samples (2), length of the data (1), data. With `step=<n>` the mean of
+ * every @p n samples follows as record: time in s (4), temperature (2),
+ * humidity (2). All numbers are big endian.
+ * @{
+ */
+#define ELECT_SERIES_VERSION    (0x01)
+#define ELECT_SERIES_FMT_BLOCKS (0x00)
+#define ELECT_SERIES_FMT_RECORDS (0x01)
+#define ELECT_SERIES_HDR_LEN    (8U)
+#define ELECT_SERIES_BLOCK_HDR_LEN (11U)
+#define ELECT_SERIES_REC_LEN    (8U)
+/** @} */
+
+/**
+ * @brief Block of samples
+ */
+typedef struct {
+    uint32_t start;         /**< time of the first sample in s */
+    int16_t temp;           /**< temperature of the first sample */
+    int16_t hum;            /**< humidity of the first sample */
+    uint16_t count;         /**< number of samples */
+    uint8_t len;            /**< bytes used in @ref data */
+    uint8_t data[ELECT_SERIES_BLOCK_SIZE];  /**< encoded samples after the first */
+} series_block_t;
+
+/**
+ * @brief Callback for decoded samples
+ *
+ * @param[in] ctx   context passed to @ref series_read
+ * @param[in] time  time of the sample in s
+ * @param[in] temp  temperature as degree Celsius x100
+ * @param[in] hum   relative humidity as percent x100
+ */
+typedef void (*series_cb_t)(void *ctx, uint32_t time, int16_t temp,
+                            int16_t hum);
+
+/**
+ * @brief Store a sample
+ *
+ * @param[in] time  time of the sample in s
+ * @param[in] temp  temperature as degree Celsius x100
+ * @param[in] hum   relative humidity as percent x100
+ */
+void series_add(uint32_t time, int16_t temp, int16_t hum);
+
+/**
+ * @brief Number of stored blocks, including the one being filled
+ */
+unsigned series_blocks(void);
+
+/**
+ * @brief Copy a block
+ *
+ * @param[in] i         index, 0 is the oldest block
+ * @param[out] block    destination
+ *
+ * @returns true on success, false if there is no block @p i
+ */
+bool series_get(unsigned i, series_block_t *block);
+
+/**
+ * @brief Decode all samples, downsampled to the mean of @p step samples
+ *
+ * @param[in] step  number of samples per output, 1 for all samples
+ * @param[in] cb    called for every output, oldest first
+ * @param[in] ctx   context passed to @p cb
+ *
+ * @returns number of outputs
+ */
+unsigned series_read(unsigned step, series_cb_t cb, void *ctx);
+
+/**
+ * @brief Decode the samples of a block
+ *
+ * @param[in] block block to decode
+ * @param[in] cb    called for every sample
+ * @param[in] ctx   context passed to @p cb
+ *
+ * @returns 0 on success, 1 if the block is corrupt
+ */
+int series_decode(const series_block_t *block, series_cb_t cb, void *ctx);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* SERIES_H */
+/** @} */
@@ -0,0 +1,111 @@
+/*
+ * Copyright (c) 2017 HAW Hamburg
+ *
+ * This file is subject to the terms and conditions of the GNU Lesser
+ * General Public License v2.1. See the file LICENSE in the top level
+ * directory for more details.
+ */
+
+/**
+ * @ingroup     vslab-riot
+ * @{
+ *
+ * @file
+ * @brief       Binary event trace
+ *
+ * @author      Sebastian Meiling <s@mlng.net>
+ *
+ * @}
+ */
+
+#include "trace.h"
+
+#if ELECT_TRACE
+
+#include "byteorder.h"
+#include "irq.h"
+#include "thread.h"
+#include "xtimer.h"
+
+#if (ELECT_TRACE_NUMOF & (ELECT_TRACE_NUMOF - 1))
+#error "ELECT_TRACE_NUMOF must be a power of two"
+#endif
+
+static trace_rec_t _ring[ELECT_TRACE_NUMOF];
+/* records written since boot, the next one goes to _total % NUMOF */
+static uint32_t _total;
+
+/* fold the interface identifier, nodes of one network differ there */
+static uint16_t _hash(const ipv6_addr_t *addr)
+{
+    if (addr == NULL) {
+        return 0;
+    }
+    uint16_t hash = 0;
+    for (unsigned i = 8; i < sizeof(addr->u8); i += 2) {
+        hash ^= (uint16_t)((addr->u8[i] << 8) | addr->u8[i + 1]);
+    }
+    return hash;
+}
+
+void trace_add(uint16_t event, uint8_t state, const ipv6_addr_t *addr,
+               int16_t arg)
+{
+    trace_rec_t rec = {
+        .time = xtimer_now_usec(),
+        .event = event,
+        .addr = _hash(addr),
+        .arg = arg,
+        .state = state,
+        .thread = (uint8_t)thread_getpid(),
+    };
+    unsigned irq = irq_disable();
+    _ring[_total++ % ELECT_TRACE_NUMOF] = rec;
+    irq_restore(irq);
+}
+
+bool trace_get(unsigned i, trace_rec_t *rec)
+{
+    bool res = false;
+    unsigned irq = irq_disable();
+    uint32_t numof = (_total < ELECT_TRACE_NUMOF) ? _total : ELECT_TRACE_NUMOF;
+    if (i < numof) {
+        *rec = _ring[(_total - numof + i) % ELECT_TRACE_NUMOF];
+        res = true;
+    }
+    irq_restore(irq);
+    return res;
+}
+
+uint32_t trace_total(void)
+{
+    unsigned irq = irq_disable();
+    uint32_t total = _total;
+    irq_restore(irq);
+    return total;
+}
+
+unsigned trace_encode_hdr(uint8_t *buf)
+{
+    uint32_t total = trace_total();
+    unsigned numof = (total < ELECT_TRACE_NUMOF) ? total : ELECT_TRACE_NUMOF;
+    buf[0] = ELECT_TRACE_VERSION;
+    buf[1] = ELECT_TRACE_REC_LEN;
+    byteorder_htobebufs(&buf[2], (uint16_t)numof);
+    byteorder_htobebufl(&buf[4], total);
+    return numof;
+}
+
+void trace_encode_rec(uint8_t *buf, const trace_rec_t *rec)
+{
+    byteorder_htobebufl(&buf[0], rec->time);
+    byteorder_htobebufs(&buf[4], rec->event);
+    byteorder_htobebufs(&buf[6], rec->addr);
+    byteorder_htobebufs(&buf[8], (uint16_t)rec->arg);
+    buf[10] = rec->state;
+    buf[11] = rec->thread;
+}
+
+#else
+typedef int dont_be_pedantic;
+#endif /* ELECT_TRACE */
@@ -0,0 +1,144 @@
+/*
+ * Copyright (c) 2017 HAW Hamburg
+ *
+ * This file is subject to the terms and conditions of the GNU Lesser
+ * General Public License v2.1. See the file LICENSE in the top level
+ * directory for more details.
+ */
+
+/**
+ * @ingroup     vslab-riot
+ * @{
+ *
+ * @file
+ * @brief       Binary event trace
+ *
+ * Trace points write fixed size records into a static ring, which is cheap
+ * enough for the hot loop and safe from any thread. The ring is served at
+ * GET `/trace` and decoded on the host with `tools/trace_decode.py`.
+ *
+ * With @ref ELECT_TRACE set to 0 all trace points compile to nothing.
+ *
+ * @author      Sebastian Meiling <s@mlng.net>
+ */
+
+#ifndef TRACE_H
+#define TRACE_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#include "net/ipv6/addr.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#ifndef ELECT_TRACE
+/**
+ * @brief Enable trace points
+ */
+#define ELECT_TRACE             (0)
+#endif
+
+#ifndef ELECT_TRACE_NUMOF
+/**
+ * @brief Number of records in the ring, must be a power of two
+ */
+#define ELECT_TRACE_NUMOF       (64U)
+#endif
+
+/**
+ * @name Trace points that are no event of the main thread
+ *
+ * Events of the main thread are traced with their ELECT_*_EVENT type.
+ * @{
+ */
+#define ELECT_TRACE_STATE       (0x0900)    /**< state change, arg: old state */
+#define ELECT_TRACE_RX_DROP     (0x0901)    /**< no receive slot, arg: event */
+#define ELECT_TRACE_EVQ_DROP    (0x0902)    /**< queue full, arg: event */
+#define ELECT_TRACE_COAP_TIMEOUT (0x0903)   /**< request timed out, arg: msg ID */
+/** @} */
+
+/**
+ * @name Encoding of the ring served at GET `/trace`
+ *
+ * Header: version (1), record length (1), number of records (2), records
+ * written since boot (4). Records follow oldest first: time in usec (4),
+ * event (2), address hash (2), argument (2), state (1), thread (1). All
+ * numbers are big endian.
+ * @{
+ */
+#define ELECT_TRACE_VERSION     (0x01)
+#define ELECT_TRACE_HDR_LEN     (8U)
+#define ELECT_TRACE_REC_LEN     (12U)
+/** @} */
+
+/**
+ * @brief Trace record
+ */
+typedef struct {
+    uint32_t time;          /**< time in usec */
+    uint16_t event;         /**< event type or ELECT_TRACE_* */
+    uint16_t addr;          /**< hash of the remote address, 0 if none */
+    int16_t arg;            /**< event specific argument */
+    uint8_t state;          /**< state of the election */
+    uint8_t thread;         /**< PID of the tracing thread */
+} trace_rec_t;
+
+/**
+ * @brief Add a record to the ring, use @ref TRACE instead
+ *
+ * @param[in] event     event type or ELECT_TRACE_*
+ * @param[in] state     state of the election
+ * @param[in] addr      remote address, may be NULL
+ * @param[in] arg       event specific argument
+ */
+void trace_add(uint16_t event, uint8_t state, const ipv6_addr_t *addr,
+               int16_t arg);
+
+/**
+ * @brief Get a record of the ring
+ *
+ * @param[in] i         index, 0 is the oldest record
+ * @param[out] rec      record
+ *
+ * @returns true on success, false if there is no record @p i
+ */
+bool trace_get(unsigned i, trace_rec_t *rec);
+
+/**
+ * @brief Number of records written since boot
+ */
+uint32_t trace_total(void);
+
+/**
+ * @brief Encode the header of the ring
+ *
+ * @param[out] buf  destination, at least @ref ELECT_TRACE_HDR_LEN bytes
+ *
+ * @returns number of records that follow
+ */
+unsigned trace_encode_hdr(uint8_t *buf);
+
+/**
+ * @brief Encode a record
+ *
+ * @param[out] buf  destination, at least @ref ELECT_TRACE_REC_LEN bytes
+ * @param[in] rec   record
+ */
+void trace_encode_rec(uint8_t *buf, const trace_rec_t *rec);
+
+#if ELECT_TRACE
+#define TRACE(event, state, addr, arg)  trace_add((event), (state), (addr), (arg))
+#else
+#define TRACE(event, state, addr, arg)  do { } while (0)
+#endif
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* TRACE_H */
+/** @} */
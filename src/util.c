@@ -17,9 +17,11 @@
  *
  * @}
  */
+#include <errno.h>
 #include <stdbool.h>
 #include <string.h>
 
+#include "byteorder.h"
 #include "log.h"
 #include "fmt.h"
 #include "msg.h"
@@ -31,20 +33,87 @@
 #include "net/gnrc/netif/hdr.h"
 #include "net/gnrc/udp.h"
 #include "net/sock/udp.h"
+#include "xtimer.h"
 
+#include "config.h"
 #include "elect.h"
+#include "elect_core.h"
+#include "evq.h"
+#include "history.h"
+#include "metrics.h"
+#include "rxpool.h"
+#include "trace.h"
 
 #define LISTEN_MSG_QUEUE_SIZE   (8U)
 #define LISTEN_STACKSIZE        (THREAD_STACKSIZE_MAIN)
 
 static char server_stack[LISTEN_STACKSIZE];
 static kernel_pid_t server_pid = KERNEL_PID_UNDEF;
+#if ELECT_CLUSTER
+static char root_stack[LISTEN_STACKSIZE];
+static kernel_pid_t root_pid = KERNEL_PID_UNDEF;
+static sock_udp_t _root_sock;
+#endif
+#if ELECT_HISTORY
+static char summary_stack[LISTEN_STACKSIZE];
+static kernel_pid_t summary_pid = KERNEL_PID_UNDEF;
+static sock_udp_t _summary_sock;
+#endif
 /* the link local IP address of this node as string */
 static ipv6_addr_t ip_addr;
 static char ip_addr_str[IPV6_ADDR_MAX_STR_LEN];
 static sock_udp_t _sock;
 
+/* last accepted election frame of a sender */
+typedef struct {
+    ipv6_addr_t addr;
+    uint32_t time;
+    uint16_t seq;
+    uint8_t type;
+} _rx_seen_t;
+
+/* filter state of an election listener, owned by its thread */
+typedef struct {
+    _rx_seen_t seen[ELECT_BC_RX_SENDERS];   /* most recent first */
+    unsigned numof;
+    rxpool_slot_t *pending;     /* highest ID of the current tick */
+    ipv6_addr_t pending_addr;
+    uint32_t tick;              /* start of the current tick in usec */
+} _rx_filter_t;
+
+/* socket of a listen thread and the event its datagrams are passed as,
+ * election frames are filtered */
+typedef struct {
+    sock_udp_t *sock;
+    uint16_t event;
+    _rx_filter_t *filter;
+} _listener_t;
+
+/* time of the last own ID sent to a group */
+typedef struct {
+    uint32_t time;
+    bool valid;
+} _holdoff_t;
+
+static _rx_filter_t _filter;
+static _holdoff_t _id_holdoff;
+static const _listener_t _listener = { &_sock, ELECT_BROADCAST_EVENT, &_filter };
+#if ELECT_CLUSTER
+static _rx_filter_t _root_filter;
+static _holdoff_t _root_id_holdoff;
+static const _listener_t _root_listener = { &_root_sock, ELECT_ROOT_BROADCAST_EVENT,
+                                            &_root_filter };
+#endif
+#if ELECT_HISTORY
+static const _listener_t _summary_listener = { &_summary_sock, ELECT_SUMMARY_EVENT,
+                                               NULL };
+#endif
+
 static kernel_pid_t main_pid;
+#ifndef ELECT_FRAME_TEXT
+/* sequence number of outgoing election frames */
+static uint16_t frame_seq;
+#endif
 
 /* --- internal helper functions --- */
 
@@ -71,26 +140,164 @@ void _get_ip_addr(ipv6_addr_t *addr)
     ipv6_addr_set_unspecified(addr);
 }
 
+#if ELECT_CLUSTER
+void get_node_global_addr(ipv6_addr_t *addr)
+{
+    ipv6_addr_t ipv6_addrs[GNRC_NETIF_IPV6_ADDRS_NUMOF];
+    gnrc_netif_t *netif = NULL;
+
+    while ((netif = gnrc_netif_iter(netif))) {
+        int res = gnrc_netapi_get(netif->pid, NETOPT_IPV6_ADDR, 0, ipv6_addrs,
+                                  sizeof(ipv6_addrs));
+        for (int i = 0; i < (res / (int)sizeof(ipv6_addr_t)); ++i) {
+            if (!ipv6_addr_is_link_local(&ipv6_addrs[i]) &&
+                !ipv6_addr_is_multicast(&ipv6_addrs[i])) {
+                memcpy(addr, &ipv6_addrs[i], sizeof(ipv6_addr_t));
+                return;
+            }
+        }
+    }
+    /* no routable address, the root election stays on this link */
+    LOG_WARNING("%s: no global address, using link local\n", __func__);
+    memcpy(addr, &ip_addr, sizeof(ip_addr));
+}
+#endif
+
+static bool _is_link_local_iid(const ipv6_addr_t *addr)
+{
+    static const uint8_t prefix[ELECT_FRAME_IID_LEN] = { 0xfe, 0x80 };
+    return (memcmp(addr->u8, prefix, sizeof(prefix)) == 0);
+}
+
+/* a duration derived from ELECT_MSG_INTERVAL in us, scaled to the runtime one */
+static uint32_t _scaled_us(uint32_t ms)
+{
+    return (uint32_t)(((uint64_t)ms * US_PER_MS *
+                       (uint32_t)config_get(ELECT_CONFIG_INTERVAL)) / ELECT_MSG_INTERVAL);
+}
+
+/* record a frame of a sender, returns false if it is a repeat to drop */
+static bool _rx_fresh(_rx_filter_t *filter, const elect_frame_t *frame,
+                      uint32_t now)
+{
+    unsigned i = 0;
+    while ((i < filter->numof) &&
+           ((filter->seen[i].type != frame->type) ||
+            (ipv6_addr_cmp(&filter->seen[i].addr, &frame->addr) != 0))) {
+        i++;
+    }
+    if (i < filter->numof) {
+        _rx_seen_t *seen = &filter->seen[i];
+        if ((now - seen->time) < _scaled_us(ELECT_BC_RX_WINDOW)) {
+            /* only a new heartbeat carries news, an ID is known already */
+            bool newer = ((int16_t)(frame->seq - seen->seq) > 0);
+            if (!newer || (frame->type != ELECT_FRAME_TYPE_ALIVE)) {
+                return false;
+            }
+        }
+    }
+    else if (filter->numof < ELECT_BC_RX_SENDERS) {
+        i = filter->numof++;
+    }
+    else {
+        /* forget the sender seen least recently */
+        i = ELECT_BC_RX_SENDERS - 1;
+    }
+    memmove(&filter->seen[1], &filter->seen[0], i * sizeof(filter->seen[0]));
+    filter->seen[0].addr = frame->addr;
+    filter->seen[0].time = now;
+    filter->seen[0].seq = frame->seq;
+    filter->seen[0].type = frame->type;
+    return true;
+}
+
+/* returns true if the slot is to be passed to main now, otherwise the
+ * filter dropped or keeps it */
+static bool _rx_filter(_rx_filter_t *filter, rxpool_slot_t *slot)
+{
+    elect_frame_t frame;
+    if (elect_frame_decode(&frame, slot->data, slot->len) != 0) {
+        /* main complains about it */
+        return true;
+    }
+    if (!_rx_fresh(filter, &frame, slot->time)) {
+        metrics_inc(ELECT_METRICS_RX_FILTERED);
+        rxpool_release(slot);
+        return false;
+    }
+    if (frame.type != ELECT_FRAME_TYPE_ID) {
+        return true;
+    }
+    /* the IDs of a tick are coalesced, only the highest matters */
+    if (filter->pending == NULL) {
+        filter->pending = slot;
+        filter->pending_addr = frame.addr;
+        filter->tick = slot->time;
+        return false;
+    }
+    metrics_inc(ELECT_METRICS_RX_COALESCED);
+    if (elect_core_is_lower(&filter->pending_addr, &frame.addr)) {
+        rxpool_release(filter->pending);
+        filter->pending = slot;
+        filter->pending_addr = frame.addr;
+    }
+    else {
+        rxpool_release(slot);
+    }
+    return false;
+}
+
 static void *_listen_loop(void *arg)
 {
-    (void)arg;
+    const _listener_t *listener = arg;
+    _rx_filter_t *filter = listener->filter;
 
     msg_t msg_queue[LISTEN_MSG_QUEUE_SIZE];
 
     msg_init_queue(msg_queue, LISTEN_MSG_QUEUE_SIZE);
 
     while (1) {
-        uint8_t buf[IPV6_ADDR_MAX_STR_LEN];
-        sock_udp_ep_t remote;
+        uint32_t timeout = SOCK_NO_TIMEOUT;
+        if ((filter != NULL) && (filter->pending != NULL)) {
+            uint32_t elapsed = xtimer_now_usec() - filter->tick;
+            if (elapsed >= (ELECT_BC_RX_TICK * US_PER_MS)) {
+                evq_post_slot(listener->event, filter->pending);
+                filter->pending = NULL;
+                continue;
+            }
+            timeout = (ELECT_BC_RX_TICK * US_PER_MS) - elapsed;
+        }
 
-        ssize_t res = sock_udp_recv(&_sock, buf, sizeof(buf),
-                                    SOCK_NO_TIMEOUT, &remote);
-        buf[res] = '\0';
+        rxpool_slot_t *slot = rxpool_alloc();
+        if (slot == NULL) {
+            TRACE(ELECT_TRACE_RX_DROP, 0, NULL, (int16_t)listener->event);
+            metrics_inc(ELECT_METRICS_RX_DROP);
+            /* drain the socket, nobody can take the datagram anyway */
+            uint8_t buf[ELECT_RXPOOL_SLOT_SIZE];
+            sock_udp_recv(listener->sock, buf, sizeof(buf), timeout, NULL);
+            continue;
+        }
+
+        ssize_t res = sock_udp_recv(listener->sock, slot->data, sizeof(slot->data),
+                                    timeout, &slot->remote);
+        if (res == -ETIMEDOUT) {
+            /* end of the tick, the pending ID is posted above */
+            rxpool_release(slot);
+            continue;
+        }
+        if (res <= 0) {
+            LOG_ERROR("%s: receive failed (%d)\n", __func__, (int)res);
+            rxpool_release(slot);
+            continue;
+        }
         LOG_DEBUG("%s: received %u byte(s)!\n", __func__, (unsigned)res);
-        msg_t m;
-        m.type = ELECT_BROADCAST_EVENT;
-        m.content.ptr = &buf[0];
-        msg_send_receive(&m, &m, main_pid);
+        metrics_inc(ELECT_METRICS_RX);
+        slot->len = (uint8_t)res;
+        slot->time = xtimer_now_usec();
+        if ((filter != NULL) && !_rx_filter(filter, slot)) {
+            continue;
+        }
+        evq_post_slot(listener->event, slot);
     }
     /* never reached */
     return NULL;
@@ -126,12 +333,36 @@ int listen_init(kernel_pid_t main)
         server_pid = thread_create(server_stack, sizeof(server_stack),
                                    (THREAD_PRIORITY_MAIN - 1),
                                    THREAD_CREATE_STACKTEST,
-                                   _listen_loop, NULL, "listen");
+                                   _listen_loop, (void *)&_listener, "listen");
         if (server_pid <= KERNEL_PID_UNDEF) {
             LOG_ERROR("%s: can not start listen thread!\n", __func__);
             return 1;
         }
     }
+#if ELECT_CLUSTER
+    if (root_pid <= KERNEL_PID_UNDEF) {
+        root_pid = thread_create(root_stack, sizeof(root_stack),
+                                 (THREAD_PRIORITY_MAIN - 1),
+                                 THREAD_CREATE_STACKTEST,
+                                 _listen_loop, (void *)&_root_listener, "root");
+        if (root_pid <= KERNEL_PID_UNDEF) {
+            LOG_ERROR("%s: can not start root listen thread!\n", __func__);
+            return 1;
+        }
+    }
+#endif
+#if ELECT_HISTORY
+    if (summary_pid <= KERNEL_PID_UNDEF) {
+        summary_pid = thread_create(summary_stack, sizeof(summary_stack),
+                                    (THREAD_PRIORITY_MAIN - 1),
+                                    THREAD_CREATE_STACKTEST, _listen_loop,
+                                    (void *)&_summary_listener, "summary");
+        if (summary_pid <= KERNEL_PID_UNDEF) {
+            LOG_ERROR("%s: can not start summary listen thread!\n", __func__);
+            return 1;
+        }
+    }
+#endif
     LOG_DEBUG("%s: done\n", __func__);
     return 0;
 }
@@ -165,6 +396,13 @@ int net_init(kernel_pid_t main)
     }
     else {
         LOG_DEBUG("%s: TX-Power: %" PRIi16 "dBm\n", __func__, txp);
+        /* the radio's default is the configured one, see /config */
+        config_t config;
+        config_read(&config);
+        config.values[ELECT_CONFIG_TXPOWER] = txp;
+        if (config_check(&config) == 0) {
+            config_commit(&config);
+        }
     }
 
     sock_udp_ep_t local;
@@ -177,6 +415,34 @@ int net_init(kernel_pid_t main)
         LOG_ERROR("%s: cannot create listen sock!\n", __func__);
         return 1;
     }
+#if ELECT_CLUSTER
+    /* the root election, the group has to be routed between clusters */
+    ipv6_addr_t root_addr = ELECT_BC_ROOT_ADDR;
+    ret = gnrc_netapi_set(iface, NETOPT_IPV6_GROUP, 0, &root_addr,
+                          sizeof(root_addr));
+    if (ret < 0) {
+        LOG_ERROR("%s: failed joining root group (%i)\n", __func__, ret);
+    }
+    local.port = ELECT_BC_ROOT_PORT;
+    if (sock_udp_create(&_root_sock, &local, NULL, 0) < 0) {
+        LOG_ERROR("%s: cannot create root sock!\n", __func__);
+        return 1;
+    }
+#endif
+#if ELECT_HISTORY
+    /* summaries of the coordinator, kept by every node */
+    ipv6_addr_t sensor_addr = ELECT_BC_SENSOR_ADDR;
+    ret = gnrc_netapi_set(iface, NETOPT_IPV6_GROUP, 0, &sensor_addr,
+                          sizeof(sensor_addr));
+    if (ret < 0) {
+        LOG_ERROR("%s: failed joining sensor group (%i)\n", __func__, ret);
+    }
+    local.port = ELECT_BC_SENSOR_PORT;
+    if (sock_udp_create(&_summary_sock, &local, NULL, 0) < 0) {
+        LOG_ERROR("%s: cannot create summary sock!\n", __func__);
+        return 1;
+    }
+#endif
     LOG_DEBUG("%s: done\n", __func__);
     return 0;
 }
@@ -191,25 +457,272 @@ int ipv6_addr_cmp(const ipv6_addr_t *ip1, const ipv6_addr_t *ip2)
     return memcmp(ip1, ip2, sizeof(ipv6_addr_t));
 }
 
-int broadcast_id(const ipv6_addr_t *ip)
+size_t elect_frame_encode(uint8_t *buf, size_t len, uint8_t type,
+                          uint16_t seq, const ipv6_addr_t *ip)
 {
-    LOG_DEBUG("%s: begin.\n", __func__);
-    ipv6_addr_t bcast_addr = ELECT_BC_NODEID_ADDR;
+    size_t alen = sizeof(ipv6_addr_t);
+    const uint8_t *addr = &ip->u8[0];
+
+    if (_is_link_local_iid(ip)) {
+        type |= ELECT_FRAME_FLAG_IID;
+        alen = ELECT_FRAME_IID_LEN;
+        addr += ELECT_FRAME_IID_LEN;
+    }
+    if (len < (ELECT_FRAME_HDR_LEN + alen)) {
+        return 0;
+    }
+    buf[0] = ELECT_FRAME_VERSION;
+    buf[1] = type;
+    byteorder_htobebufs(&buf[2], seq);
+    memcpy(&buf[ELECT_FRAME_HDR_LEN], addr, alen);
+    return ELECT_FRAME_HDR_LEN + alen;
+}
+
+int elect_frame_decode(elect_frame_t *frame, const uint8_t *buf, size_t len)
+{
+    if ((len > 0) && (buf[0] != ELECT_FRAME_VERSION)) {
+        /* text fallback for nodes sending plain address strings */
+        char str[IPV6_ADDR_MAX_STR_LEN];
+        if (len >= sizeof(str)) {
+            return 1;
+        }
+        memcpy(str, buf, len);
+        str[len] = '\0';
+        if (ipv6_addr_from_str(&frame->addr, str) == NULL) {
+            return 1;
+        }
+        frame->type = ELECT_FRAME_TYPE_ID;
+        frame->seq = 0;
+        return 0;
+    }
+    if (len < ELECT_FRAME_HDR_LEN) {
+        return 1;
+    }
+    uint8_t flags = buf[1] & ~ELECT_FRAME_TYPE_MASK;
+    frame->type = buf[1] & ELECT_FRAME_TYPE_MASK;
+    frame->seq = byteorder_bebuftohs(&buf[2]);
+    buf += ELECT_FRAME_HDR_LEN;
+    len -= ELECT_FRAME_HDR_LEN;
+    if (flags & ELECT_FRAME_FLAG_IID) {
+        if (len != ELECT_FRAME_IID_LEN) {
+            return 1;
+        }
+        ipv6_addr_set_link_local_prefix(&frame->addr);
+        memcpy(&frame->addr.u8[ELECT_FRAME_IID_LEN], buf, ELECT_FRAME_IID_LEN);
+    }
+    else {
+        if (len != sizeof(ipv6_addr_t)) {
+            return 1;
+        }
+        memcpy(&frame->addr, buf, sizeof(ipv6_addr_t));
+    }
+    return 0;
+}
+
+static int _send_frame(ipv6_addr_t dst, uint16_t port, uint8_t type,
+                       const ipv6_addr_t *ip)
+{
+#ifdef ELECT_FRAME_TEXT
+    if (type != ELECT_FRAME_TYPE_ID) {
+        return 0;
+    }
     char ip_str[IPV6_ADDR_MAX_STR_LEN];
     if (ipv6_addr_to_str(ip_str, ip, sizeof(ip_str)) == NULL) {
         LOG_ERROR("%s: failed to convert IP address!\n", __func__);
         return 1;
     }
-    return _udp_send(bcast_addr, ELECT_BC_NODEID_PORT,
-                     (uint8_t *)ip_str, strlen(ip_str));
+    return _udp_send(dst, port, (uint8_t *)ip_str, strlen(ip_str));
+#else
+    uint8_t frame[ELECT_FRAME_MAX_LEN];
+    size_t len = elect_frame_encode(frame, sizeof(frame), type, frame_seq++, ip);
+    return _udp_send(dst, port, frame, len);
+#endif
 }
 
-int broadcast_sensor(int16_t val)
+static int _send_summary(ipv6_addr_t dst, const elect_summary_t *summary)
 {
-    LOG_DEBUG("%s: begin (val=%"PRIi16").\n", __func__, val);
-    ipv6_addr_t bcast_addr = ELECT_BC_SENSOR_ADDR;
+#ifdef ELECT_FRAME_TEXT
     char val_str[ELECT_BC_SENSOR_LEN];
-    size_t len = fmt_s16_dec(val_str, val);
-    return _udp_send(bcast_addr, ELECT_BC_SENSOR_PORT,
-                     (uint8_t *)val_str, len);
+    size_t len = fmt_s16_dec(val_str, summary->average);
+    return _udp_send(dst, ELECT_BC_SENSOR_PORT, (uint8_t *)val_str, len);
+#else
+    uint8_t frame[ELECT_SUMMARY_LEN];
+    size_t len = elect_summary_encode(frame, sizeof(frame), frame_seq++,
+                                      summary);
+    return _udp_send(dst, ELECT_BC_SENSOR_PORT, frame, len);
+#endif
+}
+
+size_t elect_summary_encode(uint8_t *buf, size_t len, uint16_t seq,
+                            const elect_summary_t *summary)
+{
+    if (len < ELECT_SUMMARY_LEN) {
+        return 0;
+    }
+    buf[0] = ELECT_FRAME_VERSION;
+    buf[1] = ELECT_FRAME_TYPE_SUMMARY;
+    byteorder_htobebufs(&buf[2], seq);
+    byteorder_htobebufs(&buf[4], summary->count);
+    byteorder_htobebufs(&buf[6], (uint16_t)summary->average);
+    byteorder_htobebufs(&buf[8], (uint16_t)summary->mean);
+    byteorder_htobebufs(&buf[10], (uint16_t)summary->median);
+    byteorder_htobebufs(&buf[12], (uint16_t)summary->min);
+    byteorder_htobebufs(&buf[14], (uint16_t)summary->max);
+    for (unsigned ch = 0; ch < (ELECT_CHANNEL_NUMOF - 1); ch++) {
+        byteorder_htobebufs(&buf[ELECT_SUMMARY_BASE_LEN + (2 * ch)],
+                            (uint16_t)summary->extra[ch]);
+    }
+    return ELECT_SUMMARY_LEN;
+}
+
+int elect_summary_decode(elect_summary_t *summary, const uint8_t *buf,
+                         size_t len)
+{
+    if (((len != ELECT_SUMMARY_LEN) && (len != ELECT_SUMMARY_BASE_LEN)) ||
+        (buf[0] != ELECT_FRAME_VERSION) ||
+        ((buf[1] & ELECT_FRAME_TYPE_MASK) != ELECT_FRAME_TYPE_SUMMARY)) {
+        return 1;
+    }
+    for (unsigned ch = 0; ch < (ELECT_CHANNEL_NUMOF - 1); ch++) {
+        summary->extra[ch] = (len == ELECT_SUMMARY_LEN)
+            ? (int16_t)byteorder_bebuftohs(&buf[ELECT_SUMMARY_BASE_LEN + (2 * ch)])
+            : ELECT_VALUE_NONE;
+    }
+    summary->count = byteorder_bebuftohs(&buf[4]);
+    summary->average = (int16_t)byteorder_bebuftohs(&buf[6]);
+    summary->mean = (int16_t)byteorder_bebuftohs(&buf[8]);
+    summary->median = (int16_t)byteorder_bebuftohs(&buf[10]);
+    summary->min = (int16_t)byteorder_bebuftohs(&buf[12]);
+    summary->max = (int16_t)byteorder_bebuftohs(&buf[14]);
+    return 0;
+}
+
+size_t elect_reading_fmt(char *buf, const elect_reading_t *reading)
+{
+    size_t len = 0;
+    for (unsigned ch = 0; ch < ELECT_CHANNEL_NUMOF; ch++) {
+        if (ch > 0) {
+            buf[len++] = ',';
+        }
+        if (reading->values[ch] != ELECT_VALUE_NONE) {
+            len += fmt_s16_dec(&buf[len], reading->values[ch]);
+        }
+    }
+    buf[len] = '\0';
+    return len;
+}
+
+int elect_reading_parse(elect_reading_t *reading, const char *buf, size_t len)
+{
+    size_t i = 0;
+    for (unsigned ch = 0; ch < ELECT_CHANNEL_NUMOF; ch++) {
+        reading->values[ch] = ELECT_VALUE_NONE;
+    }
+    for (unsigned ch = 0; ch < ELECT_CHANNEL_NUMOF; ch++) {
+        bool neg = ((i < len) && (buf[i] == '-'));
+        if (neg) {
+            i++;
+        }
+        size_t digits = i;
+        int32_t val = 0;
+        while ((i < len) && (buf[i] >= '0') && (buf[i] <= '9')) {
+            val = (val * 10) + (buf[i++] - '0');
+            if (val > INT16_MAX) {
+                return 1;
+            }
+        }
+        if (i > digits) {
+            reading->values[ch] = (int16_t)(neg ? -val : val);
+        }
+        else if (neg) {
+            return 1;
+        }
+        if ((i >= len) || (buf[i] == '\0')) {
+            break;
+        }
+        /* further channels of a newer node are ignored */
+        if (buf[i++] != ',') {
+            return 1;
+        }
+    }
+    return (reading->values[ELECT_CHANNEL_TEMP] == ELECT_VALUE_NONE) ? 1 : 0;
+}
+
+/* the same ID again within the holdoff tells nobody anything new */
+static bool _holdoff(_holdoff_t *holdoff)
+{
+    uint32_t now = xtimer_now_usec();
+    if (holdoff->valid &&
+        ((now - holdoff->time) < _scaled_us(ELECT_BC_TX_HOLDOFF))) {
+        metrics_inc(ELECT_METRICS_TX_SUPPRESSED);
+        return true;
+    }
+    holdoff->time = now;
+    holdoff->valid = true;
+    return false;
+}
+
+int net_set_txpower(int16_t txpower)
+{
+    kernel_pid_t iface = gnrc_netif_iter(NULL)->pid;
+    int ret = gnrc_netapi_set(iface, NETOPT_TX_POWER, 0, &txpower, sizeof(txpower));
+    if (ret < 0) {
+        LOG_ERROR("%s: failed setting TXPOWER (%i)\n", __func__, ret);
+        return 1;
+    }
+    return 0;
+}
+
+int broadcast_id(const ipv6_addr_t *ip)
+{
+    LOG_DEBUG("%s: begin.\n", __func__);
+    if (_holdoff(&_id_holdoff)) {
+        return 1;
+    }
+    ipv6_addr_t bcast_addr = ELECT_BC_NODEID_ADDR;
+    int res = _send_frame(bcast_addr, ELECT_BC_NODEID_PORT, ELECT_FRAME_TYPE_ID, ip);
+    return (res < 0) ? res : 0;
+}
+
+int broadcast_alive(const ipv6_addr_t *ip)
+{
+    LOG_DEBUG("%s: begin.\n", __func__);
+    ipv6_addr_t bcast_addr = ELECT_BC_NODEID_ADDR;
+    return _send_frame(bcast_addr, ELECT_BC_NODEID_PORT, ELECT_FRAME_TYPE_ALIVE, ip);
+}
+
+int broadcast_summary(const elect_summary_t *summary)
+{
+    LOG_DEBUG("%s: begin (avg=%"PRIi16", n=%u).\n", __func__,
+              summary->average, (unsigned)summary->count);
+    ipv6_addr_t bcast_addr = ELECT_BC_SENSOR_ADDR;
+    return _send_summary(bcast_addr, summary);
+}
+
+#if ELECT_CLUSTER
+int broadcast_root_id(const ipv6_addr_t *ip)
+{
+    LOG_DEBUG("%s: begin.\n", __func__);
+    if (_holdoff(&_root_id_holdoff)) {
+        return 1;
+    }
+    ipv6_addr_t bcast_addr = ELECT_BC_ROOT_ADDR;
+    int res = _send_frame(bcast_addr, ELECT_BC_ROOT_PORT, ELECT_FRAME_TYPE_ID, ip);
+    return (res < 0) ? res : 0;
+}
+
+int broadcast_root_alive(const ipv6_addr_t *ip)
+{
+    LOG_DEBUG("%s: begin.\n", __func__);
+    ipv6_addr_t bcast_addr = ELECT_BC_ROOT_ADDR;
+    return _send_frame(bcast_addr, ELECT_BC_ROOT_PORT, ELECT_FRAME_TYPE_ALIVE, ip);
+}
+
+int broadcast_root_summary(const elect_summary_t *summary)
+{
+    LOG_DEBUG("%s: begin (avg=%"PRIi16", n=%u).\n", __func__,
+              summary->average, (unsigned)summary->count);
+    ipv6_addr_t bcast_addr = ELECT_BC_ROOT_ADDR;
+    return _send_summary(bcast_addr, summary);
 }
+#endif
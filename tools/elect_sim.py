@@ -0,0 +1,230 @@
+#!/usr/bin/env python3
+#
+# Copyright (c) 2017 HAW Hamburg
+#
+# This file is subject to the terms and conditions of the GNU Lesser
+# General Public License v2.1. See the file LICENSE in the top level
+# directory for more details.
+
+"""Multi-node simulation of the leader election on the native board.
+
+Builds the application once, starts N instances on a local tap bridge,
+kills and restarts the leader a number of times and reports:
+
+  - time until all nodes agreed on a leader after start
+  - time until the remaining nodes recovered after the leader died
+  - election messages sent per node
+
+Nodes report their progress with `elect: ...` log lines, see src/main.c.
+Timing parameters can be overridden to benchmark them, e.g.
+
+    tools/elect_sim.py -n 6 -D ELECT_MSG_INTERVAL=1000 --algo 1
+
+Creating the tap bridge needs root, it is done with RIOT's tapsetup tool
+unless --no-tapsetup is given.
+"""
+
+import argparse
+import os
+import re
+import subprocess
+import sys
+import threading
+import time
+
+REPO = os.path.abspath(os.path.join(os.path.dirname(__file__), os.pardir))
+APPDIR = os.path.join(REPO, "src")
+ELF = os.path.join(APPDIR, "bin", "native", "vslab-riot.elf")
+
+CONVERGED = re.compile(r"elect: converged state=(\w+) time_ms=(\d+) "
+                       r"sent=(\d+) received=(\d+)")
+LEADER_LOST = re.compile(r"elect: leader lost")
+
+
+class Node:
+    """A running native instance and the events parsed from its output."""
+
+    def __init__(self, idx, tap):
+        self.idx = idx
+        self.tap = tap
+        self.proc = None
+        self.events = []
+        self.sent = 0
+        self.lock = threading.Lock()
+
+    def start(self):
+        self.proc = subprocess.Popen([ELF, self.tap],
+                                     stdin=subprocess.DEVNULL,
+                                     stdout=subprocess.PIPE,
+                                     stderr=subprocess.STDOUT,
+                                     universal_newlines=True, bufsize=1)
+        threading.Thread(target=self._reader, args=(self.proc,),
+                         daemon=True).start()
+
+    def stop(self):
+        if self.proc is not None and self.proc.poll() is None:
+            self.proc.kill()
+            self.proc.wait()
+        self.proc = None
+
+    @property
+    def alive(self):
+        return self.proc is not None and self.proc.poll() is None
+
+    def _reader(self, proc):
+        for line in proc.stdout:
+            now = time.monotonic()
+            m = CONVERGED.search(line)
+            if m:
+                with self.lock:
+                    self.events.append((now, "converged", m.group(1)))
+                    self.sent += int(m.group(3))
+            elif LEADER_LOST.search(line):
+                with self.lock:
+                    self.events.append((now, "lost", None))
+
+    def state_since(self, since):
+        """Last election result after `since`, with its time."""
+        with self.lock:
+            for ts, kind, state in reversed(self.events):
+                if ts < since:
+                    break
+                if kind == "converged":
+                    return ts, state
+        return None, None
+
+
+def run(cmd, **kwargs):
+    print("+", " ".join(cmd), file=sys.stderr)
+    subprocess.check_call(cmd, **kwargs)
+
+
+def build(args):
+    env = dict(os.environ)
+    env["CFLAGS"] = " ".join("-D" + d for d in args.define)
+    run(["make", "-C", APPDIR, "all", "BOARD=native",
+         "RIOTBASE=" + args.riotbase, "NODES_NUM=%d" % args.nodes,
+         "ELECT_ALGO=%d" % args.algo], env=env)
+
+
+def tapsetup(args, create):
+    tool = os.path.join(args.riotbase, "dist", "tools", "tapsetup", "tapsetup")
+    cmd = [tool, "-c", str(args.nodes)] if create else [tool, "-d"]
+    if os.geteuid() != 0:
+        cmd = ["sudo"] + cmd
+    run(cmd)
+
+
+def wait_converged(nodes, since, timeout):
+    """Wait until all live nodes elected after `since` with one leader.
+
+    Returns (time of last decision, leader node) or (None, None).
+    """
+    deadline = since + timeout
+    while time.monotonic() < deadline:
+        live = [n for n in nodes if n.alive]
+        results = [n.state_since(since) for n in live]
+        if live and all(ts is not None for ts, _ in results):
+            leaders = [n for n, (_, st) in zip(live, results)
+                       if st == "coordinator"]
+            if len(leaders) == 1:
+                return max(ts for ts, _ in results), leaders[0]
+        time.sleep(0.1)
+    return None, None
+
+
+def wait_rejoined(nodes, node, since, timeout):
+    """Wait until a restarted node joined the cluster again.
+
+    If it took over as leader, all other nodes have to follow.
+    Returns (time of last decision, leader node) or (None, None).
+    """
+    deadline = since + timeout
+    while time.monotonic() < deadline:
+        ts, state = node.state_since(since)
+        if state == "client":
+            leaders = [n for n in nodes
+                       if n.alive and n.state_since(0)[1] == "coordinator"]
+            if len(leaders) == 1:
+                return ts, leaders[0]
+        elif state == "coordinator":
+            return wait_converged(nodes, since, deadline - time.monotonic())
+        time.sleep(0.1)
+    return None, None
+
+
+def main():
+    p = argparse.ArgumentParser(description=__doc__,
+                                formatter_class=argparse.RawTextHelpFormatter)
+    p.add_argument("-n", "--nodes", type=int, default=4,
+                   help="number of native instances (default: 4)")
+    p.add_argument("-c", "--crashes", type=int, default=1,
+                   help="number of leader crashes to inject (default: 1)")
+    p.add_argument("-t", "--timeout", type=float, default=120,
+                   help="max. seconds to wait for convergence (default: 120)")
+    p.add_argument("-s", "--settle", type=float, default=5,
+                   help="seconds to run stable before a crash (default: 5)")
+    p.add_argument("-D", "--define", action="append", default=[],
+                   metavar="NAME=VALUE", help="add a define to CFLAGS")
+    p.add_argument("--algo", type=int, default=0,
+                   help="election algorithm, see ELECT_ALGO (default: 0)")
+    p.add_argument("--riotbase", default=os.path.join(REPO, "RIOT"),
+                   help="path to RIOT (default: ./RIOT)")
+    p.add_argument("--no-build", action="store_true",
+                   help="use the existing binary")
+    p.add_argument("--no-tapsetup", action="store_true",
+                   help="use existing tap0..tapN-1 interfaces")
+    args = p.parse_args()
+
+    if not args.no_build:
+        build(args)
+    if not args.no_tapsetup:
+        tapsetup(args, True)
+
+    nodes = [Node(i, "tap%d" % i) for i in range(args.nodes)]
+    try:
+        start = time.monotonic()
+        for n in nodes:
+            n.start()
+        done, leader = wait_converged(nodes, start, args.timeout)
+        if done is None:
+            print("no leader elected within %.0f s" % args.timeout)
+            return 1
+        print("time-to-leader: %.2f s (leader: %s)"
+              % (done - start, leader.tap))
+
+        for i in range(args.crashes):
+            time.sleep(args.settle)
+            crash = time.monotonic()
+            leader.stop()
+            done, new_leader = wait_converged(nodes, crash, args.timeout)
+            if done is None:
+                print("crash %d: no recovery within %.0f s"
+                      % (i + 1, args.timeout))
+                return 1
+            print("crash %d: time-to-recover: %.2f s (leader: %s -> %s)"
+                  % (i + 1, done - crash, leader.tap, new_leader.tap))
+
+            restart = time.monotonic()
+            leader.start()
+            done, leader = wait_rejoined(nodes, leader, restart, args.timeout)
+            if done is None:
+                print("crash %d: no election after restart within %.0f s"
+                      % (i + 1, args.timeout))
+                return 1
+            print("crash %d: time-to-rejoin: %.2f s (leader: %s)"
+                  % (i + 1, done - restart, leader.tap))
+
+        print("election messages sent per node:")
+        for n in nodes:
+            print("  %s: %d" % (n.tap, n.sent))
+        return 0
+    finally:
+        for n in nodes:
+            n.stop()
+        if not args.no_tapsetup:
+            tapsetup(args, False)
+
+
+if __name__ == "__main__":
+    sys.exit(main())
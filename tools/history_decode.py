@@ -0,0 +1,88 @@
+#!/usr/bin/env python3
+#
+# Copyright (c) 2017 HAW Hamburg
+#
+# This file is subject to the terms and conditions of the GNU Lesser
+# General Public License v2.1. See the file LICENSE in the top level
+# directory for more details.
+
+"""Decode the summary history of a node, see src/history.h.
+
+The history is served at GET /history, any node of the cluster keeps it.
+Fetch it with libcoap's coap-client, optionally limited to an age range in
+seconds, or decode a payload saved before:
+
+    tools/history_decode.py --addr fe80::1%tap0 --since 600
+    tools/history_decode.py history.bin
+"""
+
+import argparse
+import struct
+import sys
+
+from trace_decode import fetch
+
+HDR = struct.Struct(">BBH")
+REC = struct.Struct(">IHhhhhh")
+VERSION = 0x02
+# further channels after temperature, see ELECT_CHANNEL_NUMOF
+EXTRA = ("hum",)
+NONE = -0x8000
+
+
+def decode(data):
+    if len(data) < HDR.size:
+        raise ValueError("history too short")
+    version, reclen, numof = HDR.unpack_from(data)
+    if version != VERSION or reclen < REC.size or (reclen - REC.size) % 2:
+        raise ValueError("unknown history version %d" % version)
+    extra = struct.Struct(">%dh" % ((reclen - REC.size) // 2))
+    names = tuple(EXTRA[i] if i < len(EXTRA) else "ch%d" % (i + 1)
+                  for i in range(extra.size // 2))
+    data = data[HDR.size:]
+    numof = min(numof, len(data) // reclen)
+    print("# %d records" % numof)
+    print(("%10s %5s %8s %8s %8s %8s %8s" + " %8s" * len(names))
+          % (("age", "count", "average", "mean", "median", "min", "max")
+             + names))
+    for i in range(numof):
+        age, count, avg, mean, median, vmin, vmax = REC.unpack_from(
+            data, i * reclen)
+        means = extra.unpack_from(data, i * reclen + REC.size)
+        print("%9.1fs %5d %8.2f %8.2f %8.2f %8.2f %8.2f"
+              % (age / 1000.0, count, avg / 100.0, mean / 100.0,
+                 median / 100.0, vmin / 100.0, vmax / 100.0)
+              + "".join(" %8s" % ("-" if v == NONE else "%.2f" % (v / 100.0))
+                        for v in means))
+
+
+def main():
+    p = argparse.ArgumentParser(description=__doc__,
+                                formatter_class=argparse.RawTextHelpFormatter)
+    p.add_argument("file", nargs="?",
+                   help="saved /history payload, '-' for stdin")
+    p.add_argument("--addr", help="fetch /history from this node")
+    p.add_argument("--since", type=int, default=0,
+                   help="only records younger than this many seconds")
+    p.add_argument("--until", type=int, default=0,
+                   help="only records older than this many seconds")
+    args = p.parse_args()
+
+    if args.addr:
+        data = fetch(args.addr, "/history?since=%d&until=%d"
+                     % (args.since, args.until))
+    elif args.file in (None, "-"):
+        data = sys.stdin.buffer.read()
+    else:
+        with open(args.file, "rb") as f:
+            data = f.read()
+    try:
+        decode(data)
+    except ValueError as e:
+        print("error: %s" % e, file=sys.stderr)
+        return 1
+    return 0
+
+
+if __name__ == "__main__":
+    sys.exit(main())
@@ -0,0 +1,101 @@
+#!/usr/bin/env python3
+#
+# Copyright (c) 2017 HAW Hamburg
+#
+# This file is subject to the terms and conditions of the GNU Lesser
+# General Public License v2.1. See the file LICENSE in the top level
+# directory for more details.
+
+"""Decode the runtime metrics of a node, see src/metrics.h.
+
+The metrics are served at GET /metrics, fetch them with libcoap's
+coap-client or decode a payload saved before:
+
+    tools/metrics_decode.py --addr fe80::1%tap0
+    tools/metrics_decode.py metrics.bin
+"""
+
+import argparse
+import struct
+import sys
+
+from trace_decode import event_names, fetch
+
+COUNTERS = ["rx", "rx_drop", "coap_served", "coap_sent", "coap_send_fail",
+            "coap_resp", "coap_timeout", "poll_missed", "poll_retry",
+            "poll_demoted", "rx_filtered", "rx_coalesced", "tx_suppressed"]
+EVQ = ["evq_pushed", "evq_dropped", "evq_depth", "evq_max_depth"]
+HISTS = ["queue", "handler", "poll_rtt", "poll_round"]
+
+HDR = struct.Struct(">BBBBBBH")
+VERSION = 0x01
+
+
+def _name(names, i, default):
+    return names[i] if i < len(names) else "%s%d" % (default, i)
+
+
+def _usec(usec):
+    if usec >= 1000000:
+        return "%gs" % (usec / 1e6)
+    if usec >= 1000:
+        return "%gms" % (usec / 1e3)
+    return "%dus" % usec
+
+
+def decode(data, names):
+    if len(data) < HDR.size:
+        raise ValueError("metrics too short")
+    version, ncnt, nevt, nhist, nbuckets, shift, base = HDR.unpack_from(data)
+    if version != VERSION:
+        raise ValueError("unknown metrics version %d" % version)
+    numof = ncnt + nevt + len(EVQ) + nhist * nbuckets
+    if len(data) < HDR.size + 4 * numof:
+        raise ValueError("metrics truncated")
+    values = list(struct.unpack_from(">%dI" % numof, data, HDR.size))
+
+    for i in range(ncnt):
+        print("%-24s %10d" % (_name(COUNTERS, i, "counter"), values.pop(0)))
+    for i in range(nevt):
+        count = values.pop(0)
+        if count:
+            name = names.get(base + i, "0x%04x" % (base + i))
+            print("%-24s %10d" % (name, count))
+    for name in EVQ:
+        print("%-24s %10d" % (name, values.pop(0)))
+    for h in range(nhist):
+        buckets = [values.pop(0) for _ in range(nbuckets)]
+        total = sum(buckets)
+        print("%s (%d)" % (_name(HISTS, h, "hist"), total))
+        for b, count in enumerate(buckets):
+            if not count:
+                continue
+            upper = "inf" if b == nbuckets - 1 else _usec(1 << (shift + b))
+            print("  < %-8s %10d %5.1f%%" % (upper, count, 100.0 * count / total))
+
+
+def main():
+    p = argparse.ArgumentParser(description=__doc__,
+                                formatter_class=argparse.RawTextHelpFormatter)
+    p.add_argument("file", nargs="?",
+                   help="saved /metrics payload, '-' for stdin")
+    p.add_argument("--addr", help="fetch /metrics from this node")
+    args = p.parse_args()
+
+    if args.addr:
+        data = fetch(args.addr, "/metrics")
+    elif args.file in (None, "-"):
+        data = sys.stdin.buffer.read()
+    else:
+        with open(args.file, "rb") as f:
+            data = f.read()
+    try:
+        decode(data, event_names())
+    except ValueError as e:
+        print("error: %s" % e, file=sys.stderr)
+        return 1
+    return 0
+
+
+if __name__ == "__main__":
+    sys.exit(main())
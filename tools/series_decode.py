@@ -0,0 +1,121 @@
+#!/usr/bin/env python3
+#
+# Copyright (c) 2017 HAW Hamburg
+#
+# This file is subject to the terms and conditions of the GNU Lesser
+# General Public License v2.1. See the file LICENSE in the top level
+# directory for more details.
+
+"""Decode the sensor history of a node, see src/series.h.
+
+The history is served at GET /series, either as compressed blocks or, with
+--step, downsampled on the node to the mean of every n samples. Fetch it
+with libcoap's coap-client or decode a payload saved before:
+
+    tools/series_decode.py --addr fe80::1%tap0
+    tools/series_decode.py --addr fe80::1%tap0 --step 6
+    tools/series_decode.py series.bin
+"""
+
+import argparse
+import struct
+import sys
+
+from trace_decode import fetch
+
+HDR = struct.Struct(">BBHI")
+BLOCK = struct.Struct(">IhhHB")
+REC = struct.Struct(">Ihh")
+VERSION = 0x01
+FMT_BLOCKS = 0x00
+FMT_RECORDS = 0x01
+
+
+def _varint(data, pos):
+    value = shift = 0
+    while True:
+        if pos >= len(data):
+            raise ValueError("truncated varint")
+        byte = data[pos]
+        pos += 1
+        value |= (byte & 0x7f) << shift
+        shift += 7
+        if not byte & 0x80:
+            return value, pos
+
+
+def _unzigzag(v):
+    return (v >> 1) ^ -(v & 1)
+
+
+def _blocks(data, numof):
+    pos = 0
+    for _ in range(numof):
+        if pos + BLOCK.size > len(data):
+            raise ValueError("block truncated")
+        time, temp, hum, count, dlen = BLOCK.unpack_from(data, pos)
+        pos += BLOCK.size
+        block = data[pos:pos + dlen]
+        pos += dlen
+        if count:
+            yield time, temp, hum
+        delta = bpos = 0
+        for _ in range(count - 1):
+            dod, bpos = _varint(block, bpos)
+            dtemp, bpos = _varint(block, bpos)
+            dhum, bpos = _varint(block, bpos)
+            delta += _unzigzag(dod)
+            time += delta
+            temp += _unzigzag(dtemp)
+            hum += _unzigzag(dhum)
+            yield time, temp, hum
+
+
+def _records(data, numof):
+    numof = min(numof, len(data) // REC.size)
+    for i in range(numof):
+        yield REC.unpack_from(data, i * REC.size)
+
+
+def decode(data):
+    if len(data) < HDR.size:
+        raise ValueError("series too short")
+    version, fmt, numof, now = HDR.unpack_from(data)
+    if version != VERSION or fmt not in (FMT_BLOCKS, FMT_RECORDS):
+        raise ValueError("unknown series version %d" % version)
+    data = data[HDR.size:]
+    samples = _blocks(data, numof) if fmt == FMT_BLOCKS else _records(data, numof)
+    print("%10s %8s %8s" % ("age", "temp", "hum"))
+    for time, temp, hum in samples:
+        print("%9ds %8.2f %8.2f"
+              % ((now - time) & 0xffffffff, temp / 100.0, hum / 100.0))
+
+
+def main():
+    p = argparse.ArgumentParser(description=__doc__,
+                                formatter_class=argparse.RawTextHelpFormatter)
+    p.add_argument("file", nargs="?",
+                   help="saved /series payload, '-' for stdin")
+    p.add_argument("--addr", help="fetch /series from this node")
+    p.add_argument("--step", type=int, default=0,
+                   help="let the node average every STEP samples")
+    args = p.parse_args()
+
+    if args.addr:
+        path = "/series?step=%d" % args.step if args.step else "/series"
+        data = fetch(args.addr, path)
+    elif args.file in (None, "-"):
+        data = sys.stdin.buffer.read()
+    else:
+        with open(args.file, "rb") as f:
+            data = f.read()
+    try:
+        decode(data)
+    except ValueError as e:
+        print("error: %s" % e, file=sys.stderr)
+        return 1
+    return 0
+
+
+if __name__ == "__main__":
+    sys.exit(main())
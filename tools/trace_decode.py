@@ -0,0 +1,107 @@
+#!/usr/bin/env python3
+#
+# Copyright (c) 2017 HAW Hamburg
+#
+# This file is subject to the terms and conditions of the GNU Lesser
+# General Public License v2.1. See the file LICENSE in the top level
+# directory for more details.
+
+"""Decode the binary event trace of a node, see src/trace.h.
+
+The trace is served at GET /trace. Either fetch it with libcoap's
+coap-client, which follows the block-wise transfer:
+
+    tools/trace_decode.py --addr fe80::1%tap0
+
+or decode a payload saved before:
+
+    coap-client -m get 'coap://[fe80::1%tap0]/trace' > trace.bin
+    tools/trace_decode.py trace.bin
+
+Event names are taken from the defines in src/elect.h and src/trace.h, so
+the decoder follows changes of the firmware.
+"""
+
+import argparse
+import os
+import re
+import struct
+import subprocess
+import sys
+
+REPO = os.path.abspath(os.path.join(os.path.dirname(__file__), os.pardir))
+HEADERS = [os.path.join(REPO, "src", "elect.h"),
+           os.path.join(REPO, "src", "trace.h")]
+
+DEFINE = re.compile(r"#define\s+ELECT_(\w+_EVENT|TRACE_\w+)\s+"
+                    r"\((0x[0-9a-fA-F]{4})\)")
+STATES = {0: "discovery", 1: "coordinator", 2: "client"}
+
+HDR = struct.Struct(">BBHI")
+REC = struct.Struct(">IHHhBB")
+VERSION = 0x01
+
+
+def event_names():
+    names = {}
+    for path in HEADERS:
+        with open(path) as f:
+            for line in f:
+                m = DEFINE.match(line.strip())
+                if m:
+                    names[int(m.group(2), 16)] = m.group(1).lower()
+    return names
+
+
+def fetch(addr, path="/trace"):
+    cmd = ["coap-client", "-m", "get", "coap://[%s]%s" % (addr, path)]
+    return subprocess.check_output(cmd)
+
+
+def decode(data, names):
+    if len(data) < HDR.size:
+        raise ValueError("trace too short")
+    version, reclen, numof, total = HDR.unpack_from(data)
+    if version != VERSION or reclen != REC.size:
+        raise ValueError("unknown trace version %d" % version)
+    data = data[HDR.size:]
+    numof = min(numof, len(data) // REC.size)
+    print("# %d records, %d lost since boot" % (numof, total - numof))
+    start = None
+    for i in range(numof):
+        time, event, addr, arg, state, thread = REC.unpack_from(data,
+                                                                i * REC.size)
+        if start is None:
+            start = time
+        name = names.get(event, "0x%04x" % event)
+        print("%10.3f ms  pid %-3d %-12s %-22s %s arg=%d"
+              % (((time - start) & 0xffffffff) / 1000.0, thread,
+                 STATES.get(state, str(state)), name,
+                 ("%04x" % addr) if addr else "-", arg))
+
+
+def main():
+    p = argparse.ArgumentParser(description=__doc__,
+                                formatter_class=argparse.RawTextHelpFormatter)
+    p.add_argument("file", nargs="?",
+                   help="saved /trace payload, '-' for stdin")
+    p.add_argument("--addr", help="fetch /trace from this node")
+    args = p.parse_args()
+
+    if args.addr:
+        data = fetch(args.addr)
+    elif args.file in (None, "-"):
+        data = sys.stdin.buffer.read()
+    else:
+        with open(args.file, "rb") as f:
+            data = f.read()
+    try:
+        decode(data, event_names())
+    except ValueError as e:
+        print("error: %s" % e, file=sys.stderr)
+        return 1
+    return 0
+
+
+if __name__ == "__main__":
+    sys.exit(main())